@@ -44,7 +44,7 @@
 #define DISTRHO_PLUGIN_URI "https://github.com/eventual-recluse/LiveCut"
 #define DISTRHO_PLUGIN_CLAP_ID "LiveCut.eventual-recluse"
 
-#define DISTRHO_PLUGIN_IS_RT_SAFE 0
+#define DISTRHO_PLUGIN_IS_RT_SAFE 1
 #define DISTRHO_PLUGIN_NUM_INPUTS 2
 #define DISTRHO_PLUGIN_NUM_OUTPUTS 2
 #define DISTRHO_PLUGIN_WANT_TIMEPOS 1
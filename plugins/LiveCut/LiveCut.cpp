@@ -35,11 +35,13 @@
  Boston, MA 02111-1307 USA
  */
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
 #include "DistrhoPlugin.hpp"
 #include "LiveCutControls.hpp"
-#include "BBCutter.h"
-#include "BitCrusher.h"
-#include "Comb.h"
+#include "LiveCutEngine.hpp"
 
 START_NAMESPACE_DISTRHO
 
@@ -56,29 +58,17 @@ public:
     LiveCut()
         : Plugin(LVC_CONTROL_NR, 0, 0), // (LVC_CONTROL_NR) parameters, 0 programs, 0 states
           sampleRate(getSampleRate()),
-          bbcutter(player),
-          
-          oldpositionInMeasure(0),
-          div(8)
-
+          load(0.0f),
+          loadPeak(0.0f)
     {
-         // clear all parameters
-        std::memset(control, 0, sizeof(float)*LVC_CONTROL_NR);
-        
-        // populate control with defaults
-        for (int32_t i = 0; i < LVC_CONTROL_NR; i++)
-        {
-            control[i] = LVC_DEFAULTS[i];
-        }
-        
         sampleRateChanged(sampleRate);
         
-        bbcutter.RegisterListener(&crusher);
-        bbcutter.RegisterListener(&comb);
-        
-        comb.SetOn(false);
-        crusher.SetOn(false);
-        
+#ifdef LIVECUT_PLANNER
+        engine.set_planner_enabled(true);
+#endif
+#ifdef LIVECUT_PROFILE
+        engine.set_profiling(true);
+#endif
     }
 
 protected:
@@ -467,160 +457,27 @@ protected:
             parameter.ranges.max = controlLimits[index].second;
             parameter.ranges.def = LVC_DEFAULTS[index];
             break;
-        }
-    }
-
-    /**
-      Update parameters and call relevant methods for them
-    */
-    
-    void update_parameter(uint32_t i)
-    {
-        control[i] = limit<float> (control[i], controlLimits[i].first, controlLimits[i].second);
-        
-        switch (i)
-        {
-        case LVC_CUTPROC:
-            bbcutter.SetCutProc(static_cast<long> (control[i]));
-            break;
-
-        case LVC_SUBDIV:
-            {
-                div = LVC_SUBDIV_OPTIONS[static_cast<long>(control[i])];
-                bbcutter.SetSubdiv(div);
-                break;
-            }
-
-        case LVC_FADE:
-            bbcutter.SetFade(control[i]);
-            break;
-
-        case LVC_MINAMP:
-            bbcutter.SetMinAmp(control[i]);
-            break;
-
-        case LVC_MAXAMP:
-            bbcutter.SetMaxAmp(control[i]);
-            break;
-
-        case LVC_MINPAN:
-            bbcutter.SetMinPan(control[i]);
-            break;
-
-        case LVC_MAXPAN:
-            bbcutter.SetMaxPan(control[i]);
-            break;
-
-        case LVC_MINPITCH:
-            bbcutter.SetMinDetune(control[i]);
-            break;
-
-        case LVC_MAXPITCH:
-            bbcutter.SetMaxDetune(control[i]);
-            break;
-
-        case LVC_DUTY:
-            bbcutter.SetDutyCycle(control[i]);
-            break;
-
-        case LVC_FILLDUTY:
-            bbcutter.SetFillDutyCycle(control[i]);
-            break;
-
-        case LVC_MAXPHRS:
-            bbcutter.SetMaxPhraseLength(static_cast<long> (control[i]));
-            break;
-
-        case LVC_MINPHRS:
-            bbcutter.SetMinPhraseLength(static_cast<long> (control[i]));
-            break;
-
-        case LVC_MAXREP:
-            bbcutter.SetMaxRepeats(static_cast<long> (control[i]));
-            break;
-
-        case LVC_MINREP:
-            bbcutter.SetMinRepeats(static_cast<long> (control[i]));
-            break;
-
-        case LVC_STUTTER:
-            bbcutter.SetStutterChance(control[i]);
-            break;
-
-        case LVC_AREA:
-            bbcutter.SetStutterArea(control[i]);
-            break;
-
-        case LVC_STRAIGHT:
-            bbcutter.SetStraightChance(control[i]);
-            break;
-
-        case LVC_REGULAR:
-            bbcutter.SetRegularChance(control[i]);
-            break;
-
-        case LVC_RITARD:
-            bbcutter.SetRitardChance(control[i]);
-            break;
-
-        case LVC_SPEED:
-            bbcutter.SetAccel(control[i]);
-            break;
-
-        case LVC_ACTIVITY:
-            bbcutter.SetActivity(control[i]);
-            break;
-
-        case LVC_CRUSHER:
-            crusher.SetOn(static_cast<bool> (control[i]));
-            break;
-
-        case LVC_MINBITS:
-            crusher.SetMinBits(control[i]);
-            break;
-
-        case LVC_MAXBITS:
-            crusher.SetMaxBits(control[i]);
-            break;
-
-        case LVC_MINFREQ:
-            crusher.SetMinFreq(control[i]);
-            break;
-
-        case LVC_MAXFREQ:
-            crusher.SetMaxFreq(control[i]);
-            break;
-
-        case LVC_COMB:
-            comb.SetOn(static_cast<bool> (control[i]));
-            break;
-
-        case LVC_TYPE:
-            comb.SetType(static_cast<long> (control[i]));
-            break;
-
-        case LVC_FEEDBACK:
-            comb.SetFeedBack(control[i]);
-            break;
-
-        case LVC_MINDELAY:
-            comb.SetMinDelay(control[i]);
-            break;
-
-        case LVC_MAXDELAY:
-            comb.SetMaxDelay(control[i]);
-            break;
-        
-        case LVC_SEED:
-            Math::randomseed(static_cast<long> (control[i]));
+        case LVC_LOAD:
+            parameter.name = "DSP Load";
+            parameter.symbol = "livecut_load";
+            parameter.hints = kParameterIsOutput;
+            parameter.ranges.min = controlLimits[index].first;
+            parameter.ranges.max = controlLimits[index].second;
+            parameter.ranges.def = LVC_DEFAULTS[index];
+            parameter.unit   = "%";
             break;
-            
-            
-        default:
+        case LVC_LOADPEAK:
+            parameter.name = "DSP Load Peak";
+            parameter.symbol = "livecut_loadpeak";
+            parameter.hints = kParameterIsOutput;
+            parameter.ranges.min = controlLimits[index].first;
+            parameter.ranges.max = controlLimits[index].second;
+            parameter.ranges.def = LVC_DEFAULTS[index];
+            parameter.unit   = "%";
             break;
         }
     }
-    
+
    /* --------------------------------------------------------------------------------------------------------
     * Internal data */
 
@@ -629,8 +486,15 @@ protected:
     */
     float getParameterValue(uint32_t index) const override
     {
-        if (index >= LVC_CONTROL_NR) return 0.0f;
-        return control[index];
+        switch (index)
+        {
+        case LVC_LOAD:
+            return load;
+        case LVC_LOADPEAK:
+            return loadPeak;
+        default:
+            return engine.get_parameter(index);
+        }
     }
 
    /**
@@ -638,9 +502,8 @@ protected:
     */
     void setParameterValue(uint32_t index, float value) override
     {
-        if (index >= LVC_CONTROL_NR) return;
-        control[index] = value;
-        update_parameter(index);
+        if (index == LVC_LOAD || index == LVC_LOADPEAK) return;
+        engine.set_parameter(index, value);
     }
 
    /* --------------------------------------------------------------------------------------------------------
@@ -651,17 +514,22 @@ protected:
     */
    void activate() override
    {
-        crusher.SetSampleRate(sampleRate);
-        comb.SetSampleRate(sampleRate);
-        
-        // TODO  Sample rate change?
-        //minfreq.range(100.f, sampleRate);
-        //maxfreq.range(100.f, sampleRate);
+        engine.activate();
+        load = loadPeak = 0.0f;
+   }
+
+   /**
+      Deactivate this plugin.
+    */
+   void deactivate() override
+   {
+        engine.deactivate();
         
-        for (uint32_t i = 0; i < LVC_CONTROL_NR; ++i)
-        {
-            update_parameter(i);
-        }
+#ifdef LIVECUT_PROFILE
+        // debug dump of the run() times since the last deactivate
+        engine.profiler().dump(stderr);
+        engine.profiler().reset();
+#endif
    }
 
    /**
@@ -689,45 +557,32 @@ protected:
         
         double ppqPos = (bar * beats_per_bar) + beat + beatFraction;
         
-        double ppqduration = (static_cast<double>(frames)/sampleRate) * (bpm/60.0); //duration of the block
-        double divPerSample	= (static_cast<double>(div)/beats_per_bar)*ppqduration*(beat_unit/4.0)/static_cast<double>(frames);
-        double position	= (static_cast<double>(div)/beats_per_bar) * ppqPos * (beat_unit/4.0);
-        double ref = 0.0;
-
-        bbcutter.SetTimeInfos(bpm, beats_per_bar, beat_unit, sampleRate);
-
-        long oldmeasure = static_cast<long>(std::floor((position-ref)/div));
-        long positionInMeasure = static_cast<long>(std::floor(std::fmod(position-ref, div)));
-        if (positionInMeasure != oldpositionInMeasure)
-        {
-            oldpositionInMeasure = positionInMeasure;
-            bbcutter.SetPosition(oldmeasure, oldpositionInMeasure);
-        }
-
-        for (uint32_t i = 0; i < frames; ++i)
-        {
-            positionInMeasure= static_cast<long>(std::floor(std::fmod(position-ref, div)));
-            long measure = static_cast<long>(std::floor((position-ref)/div));
-            
-            if(positionInMeasure!=oldpositionInMeasure)
-            {
-                bbcutter.SetPosition(measure,positionInMeasure);
-            }
-            
-            float l=0.f;
-            float r=0.f;
-            player.tick(l, r, inL[i], inR[i]);
-            crusher.tick(l,r,l,r);
-            comb.tick(l,r,l,r);
-            
-            outL[i] = l;
-            outR[i] = r;		
-            oldpositionInMeasure = positionInMeasure;
-            oldmeasure			 = measure;
-            position			+= divPerSample;
-        }
+        const LiveCutTransport transport = { bpm, beats_per_bar, beat_unit, ppqPos, timePos.frame };
+        
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        engine.run(inL, inR, outL, outR, frames, transport);
+        const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        
+        update_load(elapsed, frames);
     }
 
+   /**
+      Update the DSP load meters with the time taken by run(), in percent of the real-time budget.
+      The load is smoothed over about 300 ms, the peak holds the highest load and decays over about 2 s.
+    */
+    void update_load(double elapsed, uint32_t frames)
+    {
+        if (frames == 0 || sampleRate <= 0.0f) return;
+        
+        const double budget = frames / static_cast<double>(sampleRate);
+        const float current = static_cast<float>(100.0 * elapsed / budget);
+        
+        const float smoothing = std::exp(-static_cast<float>(budget) / 0.3f);
+        const float decay = std::exp(-static_cast<float>(budget) / 2.0f);
+        
+        load = current + smoothing * (load - current);
+        loadPeak = std::max(current, loadPeak * decay);
+    }
 
    /* --------------------------------------------------------------------------------------------------------
     * Callbacks (optional) */
@@ -739,6 +594,7 @@ protected:
     void sampleRateChanged(double newSampleRate) override
     {
         sampleRate = newSampleRate;
+        engine.set_sample_rate(sampleRate);
     }
 
     // -------------------------------------------------------------------------------------------------------
@@ -746,18 +602,12 @@ protected:
 private:
     float sampleRate;
     
-    // Parameters.
-    float control[LVC_CONTROL_NR];
-    
-    // Livecut components
-    LivePlayer player;
-    BitCrusher crusher;
-    Comb comb;
-    BBCutter bbcutter;
+    // Livecut processing chain
+    LiveCutEngine engine;
     
-    // Variables used by the run() method which are stored or updated outside of the run() method
-    long oldpositionInMeasure;
-    long div;
+    // DSP load meters, in percent
+    float load;
+    float loadPeak;
 
    /**
       Set our plugin class as non-copyable and add a leak detector just in case.
@@ -18,7 +18,7 @@
  Boston, MA 02111-1307 USA
  */
 
-/* Control information required by LiveCut.cpp and LiveCutUI.cpp */
+/* Control information required by LiveCut.cpp, LiveCutUI.cpp, LiveCutEngine.cpp and the offline tools */
 
 #ifndef LIVECUT_CONTROLS_HPP
 #define LIVECUT_CONTROLS_HPP
@@ -65,7 +65,9 @@ enum LiveCutControls{
     LVC_MINDELAY      = 30,
     LVC_MAXDELAY      = 31,
     LVC_SEED          = 32,
-    LVC_CONTROL_NR    = 33
+    LVC_LOAD          = 33, // output
+    LVC_LOADPEAK      = 34, // output
+    LVC_CONTROL_NR    = 35
 };
 
 static const std::array<std::pair<float, float>, LVC_CONTROL_NR> controlLimits =
@@ -102,7 +104,9 @@ static const std::array<std::pair<float, float>, LVC_CONTROL_NR> controlLimits =
     {0.0f, 0.9f},        // LVC_FEEDBACK
     {1.0f, 50.0f},       // LVC_MINDELAY
     {1.0f, 50.0f},       // LVC_MAXDELAY
-    {1.0f, 16.0f}        // LVC_SEED
+    {1.0f, 16.0f},       // LVC_SEED
+    {0.0f, 100.0f},      // LVC_LOAD
+    {0.0f, 100.0f}       // LVC_LOADPEAK
 }};
 
 static const float LVC_DEFAULTS[LVC_CONTROL_NR] = {
@@ -138,7 +142,47 @@ static const float LVC_DEFAULTS[LVC_CONTROL_NR] = {
     0.5f, // LVC_FEEDBACK
     10.0f, // LVC_MINDELAY
     10.0f, //  LVC_MAXDELAY
-    1.0f //  LVC_SEED
+    1.0f, //  LVC_SEED
+    0.0f, // LVC_LOAD
+    0.0f  // LVC_LOADPEAK
+};
+
+static const char* const LVC_SYMBOLS[LVC_CONTROL_NR] = {
+    "livecut_cutproc",   // LVC_CUTPROC
+    "livecut_subdiv",    // LVC_SUBDIV
+    "livecut_fade",      // LVC_FADE
+    "livecut_minamp",    // LVC_MINAMP
+    "livecut_maxamp",    // LVC_MAXAMP
+    "livecut_minpan",    // LVC_MINPAN
+    "livecut_maxpan",    // LVC_MAXPAN
+    "livecut_minpitch",  // LVC_MINPITCH
+    "livecut_maxpitch",  // LVC_MAXPITCH
+    "livecut_duty",      // LVC_DUTY
+    "livecut_fillduty",  // LVC_FILLDUTY
+    "livecut_maxphrs",   // LVC_MAXPHRS
+    "livecut_minphrs",   // LVC_MINPHRS
+    "livecut_maxrep",    // LVC_MAXREP
+    "livecut_minrep",    // LVC_MINREP
+    "livecut_stutter",   // LVC_STUTTER
+    "livecut_area",      // LVC_AREA
+    "livecut_straight",  // LVC_STRAIGHT
+    "livecut_regular",   // LVC_REGULAR
+    "livecut_ritard",    // LVC_RITARD
+    "livecut_speed",     // LVC_SPEED
+    "livecut_activity",  // LVC_ACTIVITY
+    "livecut_crusher",   // LVC_CRUSHER
+    "livecut_minbits",   // LVC_MINBITS
+    "livecut_maxbits",   // LVC_MAXBITS
+    "livecut_minfreq",   // LVC_MINFREQ
+    "livecut_maxfreq",   // LVC_MAXFREQ
+    "livecut_comb",      // LVC_COMB
+    "livecut_type",      // LVC_TYPE
+    "livecut_feedback",  // LVC_FEEDBACK
+    "livecut_mindelay",  // LVC_MINDELAY
+    "livecut_maxdelay",  // LVC_MAXDELAY
+    "livecut_seed",      // LVC_SEED
+    "livecut_load",      // LVC_LOAD
+    "livecut_loadpeak"   // LVC_LOADPEAK
 };
 
 static const long LVC_SUBDIV_OPTIONS[7] = {
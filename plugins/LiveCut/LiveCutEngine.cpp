@@ -0,0 +1,413 @@
+/*
+ This file is part of Livecut
+ Copyright 2004 by Remy Muller.
+ Adapted for DISTRHO Plugin Framework (DPF) by eventual-recluse.
+
+ Livecut can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+
+ Livecut is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Livecut; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA 02111-1307 USA
+ */
+
+#include "LiveCutEngine.hpp"
+
+#include <cmath>
+#include <cstring>
+
+LiveCutEngine::LiveCutEngine()
+    : sampleRate(44100.0),
+      bbcutter(player),
+      plannerEnabled(false),
+      runProfiler(player),
+      profiling(false),
+      oldpositionInMeasure(0),
+      div(8),
+      anchored(false),
+      anchorFrame(0),
+      anchorPosition(0.0),
+      anchorDivPerSample(0.0),
+      nextFrame(0)
+{
+    // clear all parameters
+    std::memset(control, 0, sizeof(float)*LVC_CONTROL_NR);
+    
+    // populate control with defaults
+    for (int32_t i = 0; i < LVC_CONTROL_NR; i++)
+    {
+        control[i] = LVC_DEFAULTS[i];
+    }
+    
+    bbcutter.RegisterListener(&crusher);
+    bbcutter.RegisterListener(&comb);
+    bbcutter.RegisterListener(&runProfiler);
+    
+    comb.SetOn(false);
+    crusher.SetOn(false);
+}
+
+void LiveCutEngine::set_sample_rate(double newSampleRate)
+{
+    sampleRate = newSampleRate;
+}
+
+void LiveCutEngine::set_planner_enabled(bool enabled)
+{
+    plannerEnabled = enabled;
+}
+
+void LiveCutEngine::set_profiling(bool enabled)
+{
+    profiling = enabled;
+}
+
+void LiveCutEngine::activate()
+{
+    crusher.SetSampleRate(sampleRate);
+    comb.SetSampleRate(sampleRate);
+    bbcutter.SetSampleRate(sampleRate);
+    player.SetMaxCutLength(bbcutter.MaxCutLength(), bbcutter.MaxFadeLength());
+    anchored = false;
+    
+    // TODO  Sample rate change?
+    //minfreq.range(100.f, sampleRate);
+    //maxfreq.range(100.f, sampleRate);
+    
+    for (uint32_t i = 0; i < LVC_CONTROL_NR; ++i)
+    {
+        update_parameter(i);
+    }
+    
+    if (plannerEnabled)
+    {
+        planner.Start();
+        bbcutter.SetPlanner(&planner);
+    }
+}
+
+void LiveCutEngine::deactivate()
+{
+    bbcutter.SetPlanner(nullptr);
+    planner.Stop();
+}
+
+void LiveCutEngine::set_parameter(uint32_t index, float value)
+{
+    if (index >= LVC_CONTROL_NR) return;
+    control[index] = value;
+    update_parameter(index);
+}
+
+float LiveCutEngine::get_parameter(uint32_t index) const
+{
+    if (index >= LVC_CONTROL_NR) return 0.0f;
+    return control[index];
+}
+
+/**
+  Update parameters and call relevant methods for them
+*/
+void LiveCutEngine::update_parameter(uint32_t i)
+{
+    control[i] = limit<float> (control[i], controlLimits[i].first, controlLimits[i].second);
+    
+    switch (i)
+    {
+    case LVC_CUTPROC:
+        bbcutter.SetCutProc(static_cast<long> (control[i]));
+        break;
+
+    case LVC_SUBDIV:
+        {
+            div = LVC_SUBDIV_OPTIONS[static_cast<long>(control[i])];
+            bbcutter.SetSubdiv(div);
+            break;
+        }
+
+    case LVC_FADE:
+        bbcutter.SetFade(control[i]);
+        break;
+
+    case LVC_MINAMP:
+        bbcutter.SetMinAmp(control[i]);
+        break;
+
+    case LVC_MAXAMP:
+        bbcutter.SetMaxAmp(control[i]);
+        break;
+
+    case LVC_MINPAN:
+        bbcutter.SetMinPan(control[i]);
+        break;
+
+    case LVC_MAXPAN:
+        bbcutter.SetMaxPan(control[i]);
+        break;
+
+    case LVC_MINPITCH:
+        bbcutter.SetMinDetune(control[i]);
+        break;
+
+    case LVC_MAXPITCH:
+        bbcutter.SetMaxDetune(control[i]);
+        break;
+
+    case LVC_DUTY:
+        bbcutter.SetDutyCycle(control[i]);
+        break;
+
+    case LVC_FILLDUTY:
+        bbcutter.SetFillDutyCycle(control[i]);
+        break;
+
+    case LVC_MAXPHRS:
+        bbcutter.SetMaxPhraseLength(static_cast<long> (control[i]));
+        break;
+
+    case LVC_MINPHRS:
+        bbcutter.SetMinPhraseLength(static_cast<long> (control[i]));
+        break;
+
+    case LVC_MAXREP:
+        bbcutter.SetMaxRepeats(static_cast<long> (control[i]));
+        break;
+
+    case LVC_MINREP:
+        bbcutter.SetMinRepeats(static_cast<long> (control[i]));
+        break;
+
+    case LVC_STUTTER:
+        bbcutter.SetStutterChance(control[i]);
+        break;
+
+    case LVC_AREA:
+        bbcutter.SetStutterArea(control[i]);
+        break;
+
+    case LVC_STRAIGHT:
+        bbcutter.SetStraightChance(control[i]);
+        break;
+
+    case LVC_REGULAR:
+        bbcutter.SetRegularChance(control[i]);
+        break;
+
+    case LVC_RITARD:
+        bbcutter.SetRitardChance(control[i]);
+        break;
+
+    case LVC_SPEED:
+        bbcutter.SetAccel(control[i]);
+        break;
+
+    case LVC_ACTIVITY:
+        bbcutter.SetActivity(control[i]);
+        break;
+
+    case LVC_CRUSHER:
+        crusher.SetOn(static_cast<bool> (control[i]));
+        break;
+
+    case LVC_MINBITS:
+        crusher.SetMinBits(control[i]);
+        break;
+
+    case LVC_MAXBITS:
+        crusher.SetMaxBits(control[i]);
+        break;
+
+    case LVC_MINFREQ:
+        crusher.SetMinFreq(control[i]);
+        break;
+
+    case LVC_MAXFREQ:
+        crusher.SetMaxFreq(control[i]);
+        break;
+
+    case LVC_COMB:
+        comb.SetOn(static_cast<bool> (control[i]));
+        break;
+
+    case LVC_TYPE:
+        comb.SetType(static_cast<long> (control[i]));
+        break;
+
+    case LVC_FEEDBACK:
+        comb.SetFeedBack(control[i]);
+        break;
+
+    case LVC_MINDELAY:
+        comb.SetMinDelay(control[i]);
+        break;
+
+    case LVC_MAXDELAY:
+        comb.SetMaxDelay(control[i]);
+        break;
+    
+    case LVC_SEED:
+        bbcutter.SetSeed(static_cast<long> (control[i]));
+        crusher.SetSeed(static_cast<long> (control[i]));
+        comb.SetSeed(static_cast<long> (control[i]));
+        break;
+        
+        
+    default:
+        break;
+    }
+}
+
+/**
+  Run/process function, the transport is the one at the first frame of the block.
+*/
+void LiveCutEngine::run(const float* inL, const float* inR, float* outL, float* outR, uint32_t frames,
+                        const LiveCutTransport& transport)
+{
+    if (! profiling)
+    {
+        run_block(inL, inR, outL, outR, frames, transport);
+        return;
+    }
+    
+    runProfiler.begin_run();
+    run_block(inL, inR, outL, outR, frames, transport);
+    runProfiler.end_run(frames, transport.frame);
+}
+
+void LiveCutEngine::run_block(const float* inL, const float* inR, float* outL, float* outR, uint32_t frames,
+                              const LiveCutTransport& transport)
+{
+    double bpm = transport.bpm;
+    double beats_per_bar = transport.beatsPerBar;
+    // denominator
+    double beat_unit = transport.beatType;
+    
+    double ppqPos = transport.beats;
+    
+    // positions are counted in units (subdivisions of the bar) since the start of the song
+    double divPerSample	= (static_cast<double>(div)/beats_per_bar)*(bpm/60.0)*(beat_unit/4.0)/sampleRate;
+    double position	= (static_cast<double>(div)/beats_per_bar) * ppqPos * (beat_unit/4.0);
+
+    bbcutter.SetTimeInfos(bpm, beats_per_bar, beat_unit, sampleRate);
+
+    // the unit grid is anchored to an absolute frame and only moves when the tempo, meter
+    // or subdivision change or when the host jumps, so that the result doesn't depend on
+    // the block size and no rounding accumulates over long renders
+    const uint64_t frame = transport.frame;
+    if (! anchored || divPerSample != anchorDivPerSample || frame != nextFrame
+        || std::fabs(position_at(frame) - position) > divPerSample)
+    {
+        anchored = divPerSample > 0.0;
+        anchorFrame = frame;
+        anchorPosition = position;
+        anchorDivPerSample = divPerSample;
+    }
+    nextFrame = frame + frames;
+
+    uint32_t start = 0;
+    if (! anchored)
+    {
+        // transport without tempo, only track the position at the block start
+        const long unit = static_cast<long>(std::floor(position));
+        if (unit_in_measure(unit) != oldpositionInMeasure)
+            set_unit(unit);
+        run_span(inL, inR, outL, outR, frames);
+        return;
+    }
+
+    // unit at the block start, consistent with the boundary frames
+    const int64_t blockStart = static_cast<int64_t>(frame);
+    long unit = static_cast<long>(std::floor(position_at(frame)));
+    while (unit_frame(unit + 1) <= blockStart)
+        ++unit;
+    while (unit_frame(unit) > blockStart)
+        --unit;
+    if (unit_in_measure(unit) != oldpositionInMeasure)
+        set_unit(unit);
+
+    // process the spans between unit boundaries in blocks,
+    // the boundaries are computed once per block instead of tracking the position per sample
+    for (++unit; ; ++unit)
+    {
+        const int64_t boundary = unit_frame(unit);
+        if (boundary >= blockStart + frames)
+            break;
+        
+        const uint32_t i = static_cast<uint32_t>(boundary - blockStart);
+        run_span(inL + start, inR + start, outL + start, outR + start, i - start);
+        start = i;
+        set_unit(unit);
+    }
+    run_span(inL + start, inR + start, outL + start, outR + start, frames - start);
+}
+
+/**
+  Unit position at an absolute frame, from the current anchor.
+*/
+double LiveCutEngine::position_at(uint64_t frame) const
+{
+    return anchorPosition + static_cast<double>(static_cast<int64_t>(frame - anchorFrame)) * anchorDivPerSample;
+}
+
+/**
+  First absolute frame at or after the start of a unit, from the current anchor.
+  Units before the anchor give frames before it, possibly negative.
+*/
+int64_t LiveCutEngine::unit_frame(long unit) const
+{
+    // boundaries that fall on a frame up to rounding belong to that frame, whatever the anchor
+    const double offset = std::ceil((static_cast<double>(unit) - anchorPosition) / anchorDivPerSample - 1e-6);
+    return static_cast<int64_t>(anchorFrame) + static_cast<int64_t>(offset);
+}
+
+/**
+  Position of a unit inside its measure, the units before the start of the song count down from the end of measure -1.
+*/
+long LiveCutEngine::unit_in_measure(long unit) const
+{
+    const long sd = unit % div;
+    return (sd < 0) ? sd + div : sd;
+}
+
+/**
+  Tell the cutter that the transport crossed into a new unit.
+*/
+void LiveCutEngine::set_unit(long unit)
+{
+    oldpositionInMeasure = unit_in_measure(unit);
+    bbcutter.SetPosition((unit - oldpositionInMeasure) / div, oldpositionInMeasure);
+}
+
+/**
+  Run the player and the cut-synchrone effects on a span without unit boundaries.
+  The player stops at each cut boundary so that the effects pick up the parameters of the new cut on its first sample.
+  The effects that are off are left out of the chain, the others process the whole cut at once.
+*/
+void LiveCutEngine::run_span(const float* inL, const float* inR, float* outL, float* outR, uint32_t frames)
+{
+    const bool crushing = crusher.IsOn();
+    const bool combing = comb.IsOn();
+    
+    while (frames > 0)
+    {
+        const uint32_t done = static_cast<uint32_t>(player.process(inL, inR, outL, outR, frames));
+        
+        if (crushing)
+            crusher.process(outL, outR, done);
+        if (combing)
+            comb.process(outL, outR, done);
+        
+        inL += done;
+        inR += done;
+        outL += done;
+        outR += done;
+        frames -= done;
+    }
+}
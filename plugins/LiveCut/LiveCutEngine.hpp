@@ -0,0 +1,126 @@
+/*
+ This file is part of Livecut
+ Copyright 2004 by Remy Muller.
+ Adapted for DISTRHO Plugin Framework (DPF) by eventual-recluse.
+
+ Livecut can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+
+ Livecut is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Livecut; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA 02111-1307 USA
+ */
+
+/* The Livecut processing chain without DPF, shared by LiveCut.cpp and the offline tools */
+
+#ifndef LIVECUT_ENGINE_HPP
+#define LIVECUT_ENGINE_HPP
+
+#include <cstdint>
+
+#include "LiveCutControls.hpp"
+#include "BBCutter.h"
+#include "BitCrusher.h"
+#include "Comb.h"
+#include "CutPlanner.h"
+#include "LiveCutProfiler.hpp"
+
+/**
+  Transport state at the start of a block, as the host reports it.
+ */
+struct LiveCutTransport
+{
+    double   bpm;          // beats per minute
+    double   beatsPerBar;  // time signature numerator
+    double   beatType;     // time signature denominator
+    double   beats;        // song position in beats, from the start of the first bar
+    uint64_t frame;        // song position in frames
+};
+
+/**
+  Player, cutter and cut-synchrone effects driven by the parameters in LiveCutControls.hpp.
+ */
+class LiveCutEngine
+{
+public:
+    LiveCutEngine();
+
+    /**
+      Set the sample rate, only while deactivated.
+    */
+    void set_sample_rate(double newSampleRate);
+
+    /**
+      Allocate the buffers for the current sample rate and apply all parameters.
+      Starts the cut planner thread when enabled.
+    */
+    void activate();
+    void deactivate();
+
+    /**
+      Plan the cuts on a background thread, takes effect on the next activate().
+    */
+    void set_planner_enabled(bool enabled);
+
+    /**
+      Record the time taken by each run() in profiler(), off by default.
+    */
+    void set_profiling(bool enabled);
+    const LiveCutProfiler& profiler() const { return runProfiler; }
+    LiveCutProfiler& profiler() { return runProfiler; }
+
+    void  set_parameter(uint32_t index, float value);
+    float get_parameter(uint32_t index) const;
+
+    /**
+      Process one block, inputs and outputs may be the same buffers.
+    */
+    void run(const float* inL, const float* inR, float* outL, float* outR, uint32_t frames,
+             const LiveCutTransport& transport);
+
+private:
+    void update_parameter(uint32_t i);
+    void run_block(const float* inL, const float* inR, float* outL, float* outR, uint32_t frames,
+                   const LiveCutTransport& transport);
+    void run_span(const float* inL, const float* inR, float* outL, float* outR, uint32_t frames);
+    long unit_in_measure(long unit) const;
+    void set_unit(long unit);
+    double position_at(uint64_t frame) const;
+    int64_t unit_frame(long unit) const;
+
+private:
+    double sampleRate;
+
+    // Parameters.
+    float control[LVC_CONTROL_NR];
+
+    // Livecut components
+    LivePlayer player;
+    BitCrusher crusher;
+    Comb comb;
+    BBCutter bbcutter;
+    CutPlanner planner;
+    bool plannerEnabled;
+    LiveCutProfiler runProfiler;
+    bool profiling;
+
+    // Variables used by the run() method which are stored or updated outside of the run() method
+    long oldpositionInMeasure;
+    long div;
+
+    // Unit grid anchor used by run()
+    bool anchored;
+    uint64_t anchorFrame;
+    double anchorPosition;
+    double anchorDivPerSample;
+    uint64_t nextFrame;
+};
+
+#endif
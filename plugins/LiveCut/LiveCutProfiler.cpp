@@ -0,0 +1,168 @@
+/*
+ This file is part of Livecut
+ Copyright 2004 by Remy Muller.
+ Adapted for DISTRHO Plugin Framework (DPF) by eventual-recluse.
+
+ Livecut can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+
+ Livecut is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Livecut; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA 02111-1307 USA
+ */
+
+#include "LiveCutProfiler.hpp"
+
+#include <cstring>
+
+LiveCutProfiler::LiveCutProfiler(const LivePlayer& player)
+    : player(player),
+      events(kNone),
+      started(0)
+{
+    reset();
+}
+
+void LiveCutProfiler::reset()
+{
+    std::memset(histogram, 0, sizeof(histogram));
+    std::memset(causeCalls, 0, sizeof(causeCalls));
+    std::memset(causeMax, 0, sizeof(causeMax));
+    calls = total = frames = 0;
+    worst = 0;
+    worstEvents = kNone;
+    worstFrames = 0;
+    worstFrame = 0;
+}
+
+const char* LiveCutProfiler::unit_name()
+{
+#if defined(__i386__) || defined(__x86_64__)
+    return "cycles";
+#else
+    return "ns";
+#endif
+}
+
+void LiveCutProfiler::end_run(uint32_t n, uint64_t frame)
+{
+    const uint64_t t = now() - started;
+
+    histogram[bucket(t)]++;
+    calls++;
+    total += t;
+    frames += n;
+
+    const unsigned c = primary(events);
+    causeCalls[c]++;
+    if (t > causeMax[c]) causeMax[c] = t;
+
+    if (t > worst)
+    {
+        worst = t;
+        worstEvents = events;
+        worstFrames = n;
+        worstFrame = frame;
+    }
+}
+
+/**
+  Four buckets per octave: the position of the leading bit and the two bits below it.
+*/
+unsigned LiveCutProfiler::bucket(uint64_t t)
+{
+    if (t < 8) return static_cast<unsigned>(t);
+    unsigned octave = 63;
+    while (!(t >> octave)) --octave;
+    return octave * kBucketsPerOctave + static_cast<unsigned>((t >> (octave - 2)) & 3);
+}
+
+uint64_t LiveCutProfiler::bucket_floor(unsigned i)
+{
+    if (i < 8) return i;
+    return static_cast<uint64_t>(kBucketsPerOctave + i % kBucketsPerOctave) << (i / kBucketsPerOctave - 2);
+}
+
+unsigned LiveCutProfiler::primary(unsigned e)
+{
+    if (e & kPhrase)   return 3;
+    if (e & kBlock)    return 2;
+    if (e & kResample) return 4;
+    if (e & kBoundary) return 1;
+    return 0;
+}
+
+const char* LiveCutProfiler::cause_name(unsigned c)
+{
+    static const char* names[kNumCauses] = { "none", "boundary", "block", "phrase", "resample" };
+    return names[c];
+}
+
+/**
+  Lower edge of the bucket holding the p-th fraction of the calls.
+*/
+uint64_t LiveCutProfiler::percentile(double p) const
+{
+    const uint64_t target = static_cast<uint64_t>(p * static_cast<double>(calls));
+    uint64_t seen = 0;
+    for (unsigned i = 0; i < kNumBuckets; i++)
+    {
+        seen += histogram[i];
+        if (seen > target) return bucket_floor(i);
+    }
+    return worst;
+}
+
+void LiveCutProfiler::dump(FILE* out) const
+{
+    const char* unit = unit_name();
+    std::fprintf(out, "run() profile: %llu calls, %llu frames, mean %.0f %s/call, %.2f %s/frame\n",
+                 (unsigned long long)calls, (unsigned long long)frames,
+                 calls ? static_cast<double>(total) / calls : 0.0, unit,
+                 frames ? static_cast<double>(total) / frames : 0.0, unit);
+    if (!calls) return;
+
+    std::fprintf(out, "  p50 >= %llu  p99 >= %llu  p99.9 >= %llu  max %llu %s\n",
+                 (unsigned long long)percentile(0.5), (unsigned long long)percentile(0.99),
+                 (unsigned long long)percentile(0.999), (unsigned long long)worst, unit);
+
+    std::fprintf(out, "  worst call: %llu %s, %u frames at frame %llu, events:",
+                 (unsigned long long)worst, unit, worstFrames, (unsigned long long)worstFrame);
+    if (worstEvents == kNone) std::fprintf(out, " none");
+    if (worstEvents & kBoundary) std::fprintf(out, " boundary");
+    if (worstEvents & kBlock)    std::fprintf(out, " block");
+    if (worstEvents & kPhrase)   std::fprintf(out, " phrase");
+    if (worstEvents & kResample) std::fprintf(out, " resample");
+    std::fprintf(out, "\n");
+
+    std::fprintf(out, "  by cause (phrase > block > resample > boundary):\n");
+    for (unsigned c = 0; c < kNumCauses; c++)
+        if (causeCalls[c])
+            std::fprintf(out, "    %-9s %10llu calls, max %llu %s\n", cause_name(c),
+                         (unsigned long long)causeCalls[c], (unsigned long long)causeMax[c], unit);
+
+    std::fprintf(out, "  histogram (%s >=, calls, cumulative):\n", unit);
+    uint64_t peak = 0;
+    for (unsigned i = 0; i < kNumBuckets; i++)
+        if (histogram[i] > peak) peak = histogram[i];
+
+    uint64_t seen = 0;
+    for (unsigned i = 0; i < kNumBuckets; i++)
+    {
+        if (!histogram[i]) continue;
+        seen += histogram[i];
+        char bar[41];
+        const unsigned width = static_cast<unsigned>((histogram[i] * 40 + peak - 1) / peak);
+        std::memset(bar, '#', width);
+        bar[width] = '\0';
+        std::fprintf(out, "    %12llu %10llu %8.4f%% %s\n", (unsigned long long)bucket_floor(i),
+                     (unsigned long long)histogram[i], 100.0 * static_cast<double>(seen) / calls, bar);
+    }
+}
@@ -0,0 +1,126 @@
+/*
+ This file is part of Livecut
+ Copyright 2004 by Remy Muller.
+ Adapted for DISTRHO Plugin Framework (DPF) by eventual-recluse.
+
+ Livecut can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+
+ Livecut is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Livecut; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA 02111-1307 USA
+ */
+
+/* Worst-case execution time profile of LiveCutEngine::run() */
+
+#ifndef LIVECUT_PROFILER_HPP
+#define LIVECUT_PROFILER_HPP
+
+#include <cstdint>
+#include <cstdio>
+
+#include "BBCutter.h"
+
+#if defined(__i386__) || defined(__x86_64__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+/**
+  Histogram of the time taken by each run() call, with the cutter events that
+  happened during the call so that the spikes can be told apart by their cause.
+  The histogram has four buckets per octave and is allocated with the profiler,
+  recording a call doesn't touch the heap.
+ */
+class LiveCutProfiler : public BBCutListener
+{
+public:
+    enum Cause
+    {
+        kNone     = 0,
+        kBoundary = 1 << 0, // unit or cut boundary
+        kBlock    = 1 << 1, // new block of cuts chosen
+        kPhrase   = 1 << 2, // new phrase
+        kResample = 1 << 3, // a pitched cut started
+        kNumCauses = 5      // including kNone
+    };
+
+    enum
+    {
+        kBucketsPerOctave = 4,
+        kNumBuckets = 64 * kBucketsPerOctave
+    };
+
+    explicit LiveCutProfiler(const LivePlayer& player);
+
+    void reset();
+
+    // counted in TSC cycles on x86 and nanoseconds elsewhere
+    static inline uint64_t now()
+    {
+#if defined(__i386__) || defined(__x86_64__)
+        return __rdtsc();
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+    static const char* unit_name();
+
+    inline void begin_run()
+    {
+        events = kNone;
+        started = now();
+    }
+    void end_run(uint32_t frames, uint64_t frame);
+
+    void OnPhrase(long bar, long sd) override { events |= kPhrase; }
+    void OnBlock(long bar, long sd) override  { events |= kBlock; }
+    void OnUnit(long bar, long sd) override   { events |= kBoundary; }
+    void OnCut(long cut, long numcuts) override
+    {
+        events |= kBoundary;
+        if (player.IsPitched()) events |= kResample;
+    }
+
+    /**
+      Print the histogram, percentiles, the worst call per cause and the worst call overall.
+    */
+    void dump(FILE* out) const;
+
+private:
+    static unsigned bucket(uint64_t t);
+    static uint64_t bucket_floor(unsigned i);
+    // the most expensive cause in a set of events, the one a call is filed under
+    static unsigned primary(unsigned events);
+    static const char* cause_name(unsigned c);
+    uint64_t percentile(double p) const;
+
+    const LivePlayer& player;
+    unsigned events;
+    uint64_t started;
+
+    uint64_t histogram[kNumBuckets];
+    uint64_t calls;
+    uint64_t total;
+    uint64_t frames;
+
+    // per primary cause, indexed by kNone, kBoundary, kBlock, kPhrase, kResample in that order
+    uint64_t causeCalls[kNumCauses];
+    uint64_t causeMax[kNumCauses];
+
+    uint64_t worst;
+    unsigned worstEvents;
+    uint32_t worstFrames;
+    uint64_t worstFrame;
+};
+
+#endif
@@ -19,6 +19,7 @@
  */
 
 #include <cstdint>
+#include <cstdio>
 #include "DistrhoUI.hpp"
 #include "ResizeHandle.hpp"
 #include "LiveCutControls.hpp"
@@ -240,6 +241,13 @@ protected:
             //ImGui::PopStyleColor();
             ImGui::PopFont();
             
+            // DSP load meter, right aligned in the title pane
+            const float load_width = UI_COLUMN_WIDTH * 0.6f;
+            ImGui::SetCursorPos(ImVec2(ImGui::GetWindowContentRegionMax().x - load_width, ImGui::GetFontSize() * 0.8f));
+            char load_text[48];
+            std::snprintf(load_text, sizeof(load_text), "DSP %.1f%%  peak %.1f%%", ui_control[LVC_LOAD], ui_control[LVC_LOADPEAK]);
+            ImGui::ProgressBar(ui_control[LVC_LOAD] / controlLimits[LVC_LOAD].second, ImVec2(load_width, 0.0f), load_text);
+            
             ImGui::EndChild();
             
             ImGui::BeginChild("control pane", ImVec2(0, 0)); // control pane holds three columns: left, middle and right
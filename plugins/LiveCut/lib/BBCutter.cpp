@@ -40,6 +40,7 @@ CutProc::CutProc()
 , filldutycycle(1.f)
 , maxphraselength(4)
 , minphraselength(1)
+, rng(NULL)
 {
 }
 
@@ -55,13 +56,14 @@ void CutProc::SetDutyCycle(float v) { dutycycle = v;}
 void CutProc::SetFillDutyCycle(float v) { filldutycycle = v;}
 void CutProc::SetMinPhraseLength(long v) { minphraselength = v;}
 void CutProc::SetMaxPhraseLength(long v) { maxphraselength = v;}
+void CutProc::SetRandom(Random *r) { rng = r;}
 
 long CutProc::ChoosePhraseLength()
 {
-  return Math::randominteger(minphraselength,maxphraselength);
+  return rng->randominteger(minphraselength,maxphraselength);
 }
 
-void CutProc::ChooseCuts(std::vector<CutInfo> &cuts,
+void CutProc::ChooseCuts(CutList &cuts,
                          long &unitsinblock,
                          long unitsdone,
                          long totalunits,
@@ -71,14 +73,17 @@ void CutProc::ChooseCuts(std::vector<CutInfo> &cuts,
 }
 
 //-------------------------------------------------------------------------------
+static const long   stutternumbers[] = { 1, 2, 3, 4, 6, 8 };
+static const double stutterprobs[]   = { 0.4, 0.3, 0.1, 0.1, 0.05, 0.05 };
+
 long CutProc11::ChooseRepeats()
 {
-  return Math::randominteger(minrepeats,maxrepeats);
+  return rng->randominteger(minrepeats,maxrepeats);
 }
 
 long CutProc11::ChooseUnitsInCut(long subdiv)
 {	// units = 2*x+1 , x is natural // 1 <= 2*x + 1 <= subdiv/2+1
-  return 2*long(Math::randomfloat(0.f, float(subdiv)/4.f)+0.5f) + 1;
+  return 2*long(rng->randomfloat(0.f, float(subdiv)/4.f)+0.5f) + 1;
 }
 
 CutProc11::CutProc11()
@@ -86,6 +91,7 @@ CutProc11::CutProc11()
 , stutterarea(0.5f)
 , minrepeats(1)
 , maxrepeats(2)
+, stuttermultipliers(stutternumbers,stutterprobs)
 {
 }
 
@@ -94,7 +100,7 @@ void CutProc11::SetStutterArea(float v) { stutterarea = v;}
 void CutProc11::SetMinRepeats(long v) { minrepeats = v+1;} //not repeats actually but occurences
 void CutProc11::SetMaxRepeats(long v) { maxrepeats = v+1;}
 
-void CutProc11::ChooseCuts(std::vector<CutInfo> &cuts,
+void CutProc11::ChooseCuts(CutList &cuts,
                            long &unitsinblock,
                            long unitsdone,
                            long totalunits,
@@ -106,21 +112,19 @@ void CutProc11::ChooseCuts(std::vector<CutInfo> &cuts,
   long repeats = 1;
   
   if( float(unitsleft)/float(subdiv) < stutterarea &&
-     Math::randomfloat(0.0, 1.0) < stutterchance) //end of phrase stutter
+     rng->randomfloat(0.0, 1.0) < stutterchance) //end of phrase stutter
   {
-    long numbers[] = { 1, 2, 3, 4, 6, 8 };
-    double probs[]  = { 0.4, 0.3, 0.1, 0.1, 0.05, 0.05 };
-    long multiplier = Math::wchoose(numbers,probs,6);
-    repeats=unitsleft*multiplier;
+    long multiplier = stuttermultipliers.choose(*rng);
+    repeats=std::min(unitsleft*multiplier,long(CutList::kMaxCuts));
     double unitsinthiscut= 1.0/multiplier;
     unitsinblock = repeats*unitsinthiscut;
     cuts.resize(repeats);
-    const float startpan    = Math::randomfloat(minpan,maxpan);
-    const float endpan      = Math::randomfloat(minpan,maxpan);
-    const float startamp    = Math::randomfloat(minamp,maxamp);
-    const float endamp      = Math::randomfloat(minamp,maxamp);
+    const float startpan    = rng->randomfloat(minpan,maxpan);
+    const float endpan      = rng->randomfloat(minpan,maxpan);
+    const float startamp    = rng->randomfloat(minamp,maxamp);
+    const float endamp      = rng->randomfloat(minamp,maxamp);
     const float startdetune = 0.f;
-    const float enddetune   = Math::randomfloat(mindetune,maxdetune);
+    const float enddetune   = rng->randomfloat(mindetune,maxdetune);
     
     for(int i=0;i<repeats;i++)
     {
@@ -166,27 +170,28 @@ void CutProc11::ChooseCuts(std::vector<CutInfo> &cuts,
       //quantize cut dutycycle to match cuts to units
       //cuts[i].length = long(double(std::max(long(dutycycle*unitsincut),1L))*spu);
       cuts[i].length = long(dutycycle*unitsincut*spu);
-      cuts[i].amp = Math::randomfloat(minamp,maxamp);
+      cuts[i].amp = rng->randomfloat(minamp,maxamp);
     }
   }
 }
 
 //-------------------------------------------------------------------------------
+static const long   blockarray[] = {1,2,4};
+static const double blockprobs[] = {0.5,0.4,0.1};
+
 long WarpCutProc::ChooseRepeats(float beatsinblock)
 {
   long repeatsarray[] = {4,8,16,32};
   
   if(beatsinblock<1.f)
-    return repeatsarray[Math::randominteger(0,2)];
+    return repeatsarray[rng->randominteger(0,2)];
   else
-    return repeatsarray[Math::randominteger(1,3)];
+    return repeatsarray[rng->randominteger(1,3)];
 }
 
 long WarpCutProc::ChooseBlockSize()
 {
-  long blockarray[] = {1,2,4};
-  double blockprobs[]  = {0.5,0.4,0.1};
-  return Math::wchoose(blockarray,blockprobs,3);
+  return blocksizes.choose(*rng);
 }
 
 WarpCutProc::WarpCutProc()
@@ -194,6 +199,7 @@ WarpCutProc::WarpCutProc()
 , regularchance(0.7)
 , ritardchance(0.6)
 , accel(0.9)
+, blocksizes(blockarray,blockprobs)
 {
 }
 
@@ -202,7 +208,7 @@ void WarpCutProc::SetRegularChance(float chance) { regularchance = chance;}
 void WarpCutProc::SetRitardChance(float chance) { ritardchance = chance;}
 void WarpCutProc::SetAccel(float v) { accel = v;}
 
-void WarpCutProc::ChooseCuts(std::vector<CutInfo> &cuts,
+void WarpCutProc::ChooseCuts(CutList &cuts,
                              long &unitsinblock,
                              long unitsdone,
                              long totalunits,
@@ -215,7 +221,7 @@ void WarpCutProc::ChooseCuts(std::vector<CutInfo> &cuts,
   if(unitsinblock>unitsleft)
     unitsinblock = unitsleft;
   
-  if(Math::randomfloat(0.0, 1.0)< straightchance)
+  if(rng->randomfloat(0.0, 1.0)< straightchance)
   {
     double temp = double(unitsinblock)/double(repeats);
     cuts.resize(repeats);
@@ -225,23 +231,23 @@ void WarpCutProc::ChooseCuts(std::vector<CutInfo> &cuts,
       cuts[i].size = l;
       //quantize cut dutycycle to match cuts to units
       cuts[i].length = long(double(std::max(long(dutycycle*temp),1L))*spu);
-      cuts[i].amp = Math::randomfloat(minamp,maxamp);
+      cuts[i].amp = rng->randomfloat(minamp,maxamp);
     }
   }
   else
   {
     repeats = ChooseRepeats(float(unitsinblock)/float(subdiv));
-    const float startpan    = Math::randomfloat(minpan,maxpan);
-    const float endpan      = Math::randomfloat(minpan,maxpan);
-    const float startamp    = Math::randomfloat(minamp,maxamp);
-    const float endamp      = Math::randomfloat(minamp,maxamp);
-    const float startdetune = 0.f; //Math::randomfloat(mindetune,maxdetune);
-    const float enddetune   = Math::randomfloat(mindetune,maxdetune);
+    const float startpan    = rng->randomfloat(minpan,maxpan);
+    const float endpan      = rng->randomfloat(minpan,maxpan);
+    const float startamp    = rng->randomfloat(minamp,maxamp);
+    const float endamp      = rng->randomfloat(minamp,maxamp);
+    const float startdetune = 0.f; //rng->randomfloat(mindetune,maxdetune);
+    const float enddetune   = rng->randomfloat(mindetune,maxdetune);
     
-    if(Math::randomfloat(0.0, 1.0)< regularchance)
+    if(rng->randomfloat(0.0, 1.0)< regularchance)
     {
       //long repeatsarray[] = {4,6,8,12,16,18,24,32};
-      //repeats = repeatsarray[Math::randominteger(0,7)];
+      //repeats = repeatsarray[rng->randominteger(0,7)];
       double temp = double(unitsinblock)/double(repeats);
       cuts.resize(repeats);
       for(int i=0;i<repeats;i++)
@@ -269,7 +275,7 @@ void WarpCutProc::ChooseCuts(std::vector<CutInfo> &cuts,
         cuts[i].amp = startamp + (endamp-startamp)*phase;
         cuts[i].cents = startdetune + (enddetune-startdetune)*phase;
       }
-      if(Math::randomfloat(0.0, 1.0)< ritardchance)
+      if(rng->randomfloat(0.0, 1.0)< ritardchance)
         std::reverse(cuts.begin(),cuts.end());
     }
   }
@@ -282,7 +288,7 @@ SQPusherCutProc::SQPusherCutProc()
 , fillnumber(0)
 , fillpos(0)
 {
-  sqpusherinit();
+  sequences();
 }
 
 void SQPusherCutProc::SetActivity(float v)
@@ -290,10 +296,17 @@ void SQPusherCutProc::SetActivity(float v)
   activity=v;
 }
 
-void SQPusherCutProc::sqpusherinit()
+const SQPusherCutProc::CutSequence &SQPusherCutProc::sequences()
+{
+  // shared by all instances, so that copying the proc doesn't allocate
+  static const CutSequence cs = sqpusherinit();
+  return cs;
+}
+
+SQPusherCutProc::CutSequence SQPusherCutProc::sqpusherinit()
 {
   //boring manual initialisation
-  cs.resize(13);
+  CutSequence cs(13);
   
   cs[0].resize(2);
   cs[0][0].push_back(0.75);cs[0][0].push_back(0.75);cs[0][0].push_back(0.75);cs[0][0].push_back(0.75);
@@ -363,6 +376,7 @@ void SQPusherCutProc::sqpusherinit()
   cs[12][2].push_back(0.125);cs[12][2].push_back(0.125);cs[12][2].push_back(0.125);cs[12][2].push_back(0.125);
   cs[12][3].push_back(1.0);
   cs[12][4].push_back(0.167); cs[12][4].push_back(0.167); cs[12][4].push_back(0.166);
+  return cs;
 }
 
 long SQPusherCutProc::ChoosePhraseLength()
@@ -371,13 +385,14 @@ long SQPusherCutProc::ChoosePhraseLength()
   return CutProc::ChoosePhraseLength();
 }
 
-void SQPusherCutProc::ChooseCuts(std::vector<CutInfo> &cuts,
+void SQPusherCutProc::ChooseCuts(CutList &cuts,
                                  long &unitsinblock,
                                  long unitsdone,
                                  long totalunits,
                                  long subdiv,
                                  double spu)
 {
+  const CutSequence &cs = sequences();
   const long unitsleft = subdiv - (unitsdone%subdiv); //one bar at a time
   double done = double(unitsdone)/double(subdiv);
   long phrase  = long(done);                   //{0,1,2,3} bars
@@ -393,7 +408,7 @@ void SQPusherCutProc::ChooseCuts(std::vector<CutInfo> &cuts,
   if((totalunits-unitsdone) == subdiv)
   {
     fill = true;
-    fillnumber = Math::randominteger(0,12);
+    fillnumber = rng->randominteger(0,12);
     fillpos=0;
   }
   
@@ -410,9 +425,9 @@ void SQPusherCutProc::ChooseCuts(std::vector<CutInfo> &cuts,
         long l = long(spb * cs[fillnumber][fillpos][i]);
         cuts[i].size = l;
         cuts[i].length = long(spb * cs[fillnumber][fillpos][i] * filldutycycle);
-        cuts[i].pan = Math::randomfloat(minpan,maxpan);
-        cuts[i].amp = Math::randomfloat(minamp,maxamp);
-        cuts[i].cents = Math::randomfloat(mindetune,maxdetune);
+        cuts[i].pan = rng->randomfloat(minpan,maxpan);
+        cuts[i].amp = rng->randomfloat(minamp,maxamp);
+        cuts[i].cents = rng->randomfloat(mindetune,maxdetune);
       }
       unitsdone = long(double(subdiv)*beatsdone/4.0);
       if(unitsinblock>unitsleft)
@@ -428,7 +443,7 @@ void SQPusherCutProc::ChooseCuts(std::vector<CutInfo> &cuts,
   }
   
   {
-    long temp = 1 + 2*Math::randominteger(0,1);
+    long temp = 1 + 2*rng->randominteger(0,1);
     if(beatpos == 2)
       temp=1;
     
@@ -436,16 +451,16 @@ void SQPusherCutProc::ChooseCuts(std::vector<CutInfo> &cuts,
     if(unitsinblock>unitsleft)
       unitsinblock=unitsleft; //will automatically interrupt cutsequence before its end
     
-    if(Math::randomfloat(0.0,1.0) < sqchance) // 2*temp semiquaver
+    if(rng->randomfloat(0.0,1.0) < sqchance) // 2*temp semiquaver
     {
       cuts.resize(temp*2);
       for(int i=0;i<cuts.size();i++)
       {
         long l = long(0.25*spb);
         cuts[i].size = l;
-        cuts[i].pan = Math::randomfloat(minpan,maxpan);
-        cuts[i].amp = Math::randomfloat(minamp,maxamp);
-        cuts[i].cents = Math::randomfloat(mindetune,maxdetune);
+        cuts[i].pan = rng->randomfloat(minpan,maxpan);
+        cuts[i].amp = rng->randomfloat(minamp,maxamp);
+        cuts[i].cents = rng->randomfloat(mindetune,maxdetune);
         cuts[i].length = long(0.25*spb*dutycycle);
       }
     }
@@ -456,8 +471,8 @@ void SQPusherCutProc::ChooseCuts(std::vector<CutInfo> &cuts,
       {
         long l = long(0.5*spb);
         cuts[i].size = l;
-        cuts[i].amp = Math::randomfloat(minamp,maxamp);
-        cuts[i].cents = Math::randomfloat(mindetune,maxdetune);
+        cuts[i].amp = rng->randomfloat(minamp,maxamp);
+        cuts[i].cents = rng->randomfloat(mindetune,maxdetune);
         cuts[i].length = long(0.5*spb*dutycycle);
       }
     }
@@ -507,7 +522,14 @@ void ListenerManager::RegisterListener(BBCutListener *l)
 
 //------------------------------------------------------------------------
 LivePlayer::LivePlayer()
-: currentcut(0)
+: envtable(1,1.f)
+, fadelength(0)
+, pitched(false)
+, ratio(1.0)
+, pitchlimit(0)
+, currentcut(0)
+, maxcutlength(0)
+, blocklength(0)
 , inputindex(0)
 , readindex(0)
 , ll(0.f)
@@ -515,8 +537,8 @@ LivePlayer::LivePlayer()
 , rl(0.f)
 , rr(0.f)
 , fade(0)
-, L(&inputbufferL)
-, R(&inputbufferR)
+, cuts(&cutlists[0])
+, nextcuts(&cutlists[1])
 , listenermanager(NULL)
 {
 }
@@ -530,45 +552,274 @@ void LivePlayer::SetFade(float v)
 {
   if(v<1.f) v = 1.f ; //0.1f;
   fade = v;
+  UpdateEnvelope();
 }
 
-void LivePlayer::OnBlock(std::vector<CutInfo> newcuts)
+void LivePlayer::UpdateEnvelope()
 {
-  if(!newcuts.empty())
+  // fade-in half of envelope(), past 3.5 fades it rounds to 1.f anyway.
+  // the table is sized by SetMaxCutLength(), this only refills it
+  fadelength = std::min(long(std::ceil(3.5*double(fade))),long(envtable.size())-1);
+  
+  // exp(-5*i/fade) by recurrence
+  const double q = exp(-5.0/double(fade));
+  double e = 1.0;
+  for(long i=0;i<fadelength;++i)
   {
-    cuts = newcuts;
+    envtable[i] = float(1.0-e);
+    e *= q;
+  }
+  envtable[fadelength] = 1.f;
+}
+
+void LivePlayer::SetMaxCutLength(long v, long maxfade)
+{
+  // the only allocation of the player, call it outside of the audio thread
+  maxcutlength = std::max(v,0L);
+  inputbufferL.resize(maxcutlength,0.f);
+  inputbufferR.resize(maxcutlength,0.f);
+  // a cut never reaches maxcutlength samples so longer tables are useless
+  const long tablelength = std::min(long(std::ceil(3.5*double(std::max(maxfade,1L)))),maxcutlength);
+  envtable.assign(tablelength+1,1.f);
+  UpdateEnvelope();
+  cuts->clear();
+  nextcuts->clear();
+  currentcut = 0;
+  inputindex = readindex = 0;
+  blocklength = 0;
+}
+
+void LivePlayer::OnBlock()
+{
+  if(!nextcuts->empty())
+  {
+    std::swap(cuts,nextcuts);
+    // cuts longer than the buffers (tempo below kMinTempo) get truncated
+    for(int i=0;i<cuts->size();i++)
+      if((*cuts)[i].length>maxcutlength)
+        (*cuts)[i].length = maxcutlength;
     //rotation matrix
     // [ll lr]
     // [rl rr]
-    const float pan = cuts[0].pan;
-    const float amp = cuts[0].amp;
+    const float pan = (*cuts)[0].pan;
+    const float amp = (*cuts)[0].amp;
     ll = amp * ((pan<0)? 1.f :  cos(pan*2*pi_4));
     lr = amp * ((pan<0)? 0.f :  sin(pan*2*pi_4));
     rl = amp * ((pan>0)? 0.f : -sin(pan*2*pi_4));
     rr = amp * ((pan>0)? 1.f :  cos(pan*2*pi_4));
     inputindex = readindex = 0;
     currentcut=0;
+    pitched = false;
     
     // tell cut-synchrone effects
     if(listenermanager)
-      listenermanager->OnCut(currentcut,cuts.size()); // allow interpolation...
+      listenermanager->OnCut(currentcut,cuts->size()); // allow interpolation...
     
     
-    long maxcutlength=0;
-    for(int i=0;i<cuts.size();i++)
-      if(cuts[i].size>maxcutlength)
-        maxcutlength = cuts[i].size;
+    blocklength=0;
+    for(int i=0;i<cuts->size();i++)
+      if((*cuts)[i].size>blocklength)
+        blocklength = (*cuts)[i].size;
+    if(blocklength>maxcutlength)
+      blocklength = maxcutlength;
+  }
+}
+
+bool LivePlayer::NextCut()
+{
+  currentcut++;
+  readindex = 0;
+  if(currentcut>=cuts->size())
+    return false;
+  
+  const float amp = (*cuts)[currentcut].amp;
+  const float pan = (*cuts)[currentcut].pan;
+  ll = amp * ((pan<0)? 1.f :  cos(pan*2*pi_4));
+  lr = amp * ((pan<0)? 0.f :  sin(pan*2*pi_4));
+  rl = amp * ((pan>0)? 0.f : -sin(pan*2*pi_4));
+  rr = amp * ((pan>0)? 1.f :  cos(pan*2*pi_4));
+  
+  pitched = fabs((*cuts)[currentcut].cents) > 1e-10;
+  if(pitched)
+  {
+    // the resampler only sees what was captured before the cut started
+    ratio = pow(2.f,(*cuts)[currentcut].cents/1200.f);
+    pitchlimit = inputindex;
+  }
+  // tell cut-synchrone effects
+  if(listenermanager)
+    listenermanager->OnCut(currentcut,cuts->size()); // allow interpolation...
+  
+  return true;
+}
+
+long LivePlayer::process(const float *inL, const float *inR, float *outL, float *outR, long n)
+{
+  if(n<=0)
+    return 0;
+  
+  // the previous call stopped at the end of a cut
+  if(currentcut<cuts->size() && readindex>=(*cuts)[currentcut].size)
+    NextCut();
+  
+  if(currentcut>=cuts->size())
+  {
+    std::fill(outL,outL+n,0.f);
+    std::fill(outR,outR+n,0.f);
+    return n;
+  }
+  
+  const CutInfo &cut = (*cuts)[currentcut];
+  const long run = std::max(1L,std::min(n,cut.size-readindex));
+  
+  //store input, before writing anything in case we process in place
+  const long stored = std::max(0L,std::min(run,blocklength-inputindex));
+  if(stored>0)
+  {
+    std::copy(inL,inL+stored,&inputbufferL[inputindex]);
+    std::copy(inR,inR+stored,&inputbufferR[inputindex]);
+    inputindex += stored;
+  }
+  
+  //dutycycle on
+  const long on = std::max(0L,std::min(run,cut.length-readindex));
+  if(on>0)
+  {
+    //rotation matrix
+    if(pitched)
+    {
+      for(long i=0;i<on;++i)
+      {
+        const double p = double(readindex+i)*ratio;
+        const long pos = long(p);
+        const float frac = float(p-double(pos));
+        const float l = captured(inputbufferL,pos)*(1-frac) + captured(inputbufferL,pos+1)*frac;
+        const float r = captured(inputbufferR,pos)*(1-frac) + captured(inputbufferR,pos+1)*frac;
+        outL[i] = ll*l + rl*r;
+        outR[i] = lr*l + rr*r;
+      }
+    }
+    else
+    {
+      const float *srcL = &inputbufferL[readindex];
+      const float *srcR = &inputbufferR[readindex];
+      for(long i=0;i<on;++i)
+      {
+        outL[i] = ll*srcL[i] + rl*srcR[i];
+        outR[i] = lr*srcL[i] + rr*srcR[i];
+      }
+    }
     
-    inputbufferL.resize(maxcutlength,0.f);
-    inputbufferR.resize(maxcutlength,0.f);
-    pitchedbufferL.resize(maxcutlength,0.f);
-    pitchedbufferR.resize(maxcutlength,0.f);
-    L = &inputbufferL;
-    R = &inputbufferR;
+    //envelope, flat between the fade-in and the fade-out
+    const long flatstart = std::min(on,std::max(0L,fadelength-readindex));
+    const long flatend   = std::max(flatstart,std::min(on,cut.length-fadelength-readindex+1));
+    for(long i=0;i<flatstart;++i)
+    {
+      const float env = envelope(readindex+i,cut.length);
+      outL[i] *= env;
+      outR[i] *= env;
+    }
+    for(long i=flatend;i<on;++i)
+    {
+      const float env = envelope(readindex+i,cut.length);
+      outL[i] *= env;
+      outR[i] *= env;
+    }
   }
+  
+  //dutycycle off
+  std::fill(outL+on,outL+run,0.f);
+  std::fill(outR+on,outR+run,0.f);
+  readindex += run;
+  
+  if(readindex>=cut.size && currentcut+1>=cuts->size()) //end of the last cut
+  {
+    outL[run-1] = 0.f;
+    outR[run-1] = 0.f;
+  }
+  return run;
+}
+
+//-------------------------------------------------------------------------------
+CutState::CutState()
+: strategy(kCutProc11)
+, seed(1)
+{
+  Bind();
+}
+
+CutState::CutState(const CutState &other)
+: cutproc11(other.cutproc11)
+, warpcutproc(other.warpcutproc)
+, sqpusher(other.sqpusher)
+, rng(other.rng)
+, strategy(other.strategy)
+, seed(other.seed)
+{
+  Bind();
+}
+
+CutState &CutState::operator=(const CutState &other)
+{
+  cutproc11 = other.cutproc11;
+  warpcutproc = other.warpcutproc;
+  sqpusher = other.sqpusher;
+  rng = other.rng;
+  strategy = other.strategy;
+  seed = other.seed;
+  Bind();
+  return *this;
+}
+
+void CutState::Bind()
+{
+  cutproc11.SetRandom(&rng);
+  warpcutproc.SetRandom(&rng);
+  sqpusher.SetRandom(&rng);
+}
+
+CutProc *CutState::Strategy()
+{
+  switch(strategy)
+  {
+    case kWarpCut:  return &warpcutproc;
+    case kSQPusher: return &sqpusher;
+    default:        return &cutproc11;
+  }
+}
+
+long CutState::PhraseLength(long phrase)
+{
+  rng.seed(Random::key(seed,phrase,-1));
+  return Strategy()->ChoosePhraseLength();
+}
+
+void CutState::LocatePhrase(long bar, long &phrase, long &start, long &length)
+{
+  const long group = (bar>=0) ? bar/kPhraseGroupBars : -((kPhraseGroupBars-1-bar)/kPhraseGroupBars);
+  const long end = (group+1)*kPhraseGroupBars;
+  // each phrase is at least a bar, a group has at most kPhraseGroupBars of them
+  phrase = group*kPhraseGroupBars;
+  start = group*kPhraseGroupBars;
+  for(;;)
+  {
+    length = std::min(std::max(PhraseLength(phrase),1L),end-start);
+    if(bar<start+length)
+      break;
+    start += length;
+    phrase++;
+  }
+}
+
+void CutState::ChooseCuts(CutList &cuts, long &unitsinblock,
+                          long phrase, long unitsdone, long totalunits, long subdiv, double spu)
+{
+  rng.seed(Random::key(seed,phrase,unitsdone));
+  Strategy()->ChooseCuts(cuts,unitsinblock,unitsdone,totalunits,subdiv,spu);
 }
 
 //------------------------------------------------------------------------------------------------
+#include "CutPlanner.h"
 #include <algorithm>
 #include <functional>
 #include <cassert>
@@ -592,12 +843,16 @@ BBCutter::BBCutter(LivePlayer &player)
 , unitsinsideblock(0)
 , barsinsample(1)
 , slicestart(0)
-, strategy(&cutproc11)
+, phraseindex(0)
+, phrasebar(0)
+, planner(NULL)
+, epoch(0)
+, snapshotpending(false)
 {
   procs.reserve(kNumCutProcs);
-  procs.push_back(&cutproc11);
-  procs.push_back(&warpcutproc);
-  procs.push_back(&sqpusher);
+  procs.push_back(&state.cutproc11);
+  procs.push_back(&state.warpcutproc);
+  procs.push_back(&state.sqpusher);
   
   player.SetListenerManager(&listenermanager);
 }
@@ -616,35 +871,43 @@ void	BBCutter::SetCutProc(long i)
   assert(i>=0 && i<procs.size());
   if(i>=0 && i<procs.size())
   {
-    strategy = procs[i];
+    state.strategy = i;
+    Replan();
   }
 }
 
 void	BBCutter::SetBarsInSample(long bars) { barsinsample = bars; UpdateRates(); }
 void	BBCutter::SetTempo(double v) { tempo=v; UpdateRates(); }
-void	BBCutter::SetSubdiv(long v) { subdiv = v; UpdateRates(); }
-void	BBCutter::SetStutterChance(float chance)  { cutproc11.SetStutterChance(chance);}
-void	BBCutter::SetStutterArea(float area)      { cutproc11.SetStutterArea(area);}
-void	BBCutter::SetMaxRepeats(long repeats)     { cutproc11.SetMaxRepeats(repeats);}
-void	BBCutter::SetMinRepeats(long repeats)     { cutproc11.SetMinRepeats(repeats);}
-void	BBCutter::SetStraightChance(float chance) { warpcutproc.SetStraightChance(chance);}
-void	BBCutter::SetRegularChance(float chance)  { warpcutproc.SetRegularChance(chance);}
-void	BBCutter::SetRitardChance(float chance)   { warpcutproc.SetRitardChance(chance);}
-void	BBCutter::SetAccel(float v)               { warpcutproc.SetAccel(v);}
-void	BBCutter::SetActivity(float v)            { sqpusher.SetActivity(v);}
+void	BBCutter::SetSubdiv(long v) { subdiv = v; if(totalunits>0) totalunits = barsnow*subdiv; UpdateRates(); }
+void	BBCutter::SetStutterChance(float chance)  { state.cutproc11.SetStutterChance(chance); Replan();}
+void	BBCutter::SetStutterArea(float area)      { state.cutproc11.SetStutterArea(area); Replan();}
+void	BBCutter::SetMaxRepeats(long repeats)     { state.cutproc11.SetMaxRepeats(repeats); Replan();}
+void	BBCutter::SetMinRepeats(long repeats)     { state.cutproc11.SetMinRepeats(repeats); Replan();}
+void	BBCutter::SetStraightChance(float chance) { state.warpcutproc.SetStraightChance(chance); Replan();}
+void	BBCutter::SetRegularChance(float chance)  { state.warpcutproc.SetRegularChance(chance); Replan();}
+void	BBCutter::SetRitardChance(float chance)   { state.warpcutproc.SetRitardChance(chance); Replan();}
+void	BBCutter::SetAccel(float v)               { state.warpcutproc.SetAccel(v); Replan();}
+void	BBCutter::SetActivity(float v)            { state.sqpusher.SetActivity(v); Replan();}
 void	BBCutter::SetFade(float v)                { player.SetFade( ms2samples(v,sr) );}
-void	BBCutter::SetMinPhraseLength(long v) { for_each(procs.begin(),procs.end(),bind2nd(mem_fun(&CutProc::SetMinPhraseLength),v));}
-void	BBCutter::SetMaxPhraseLength(long v) { for_each(procs.begin(),procs.end(),bind2nd(mem_fun(&CutProc::SetMaxPhraseLength),v));}
-void	BBCutter::SetMinAmp(float v)      { for_each(procs.begin(),procs.end(),bind2nd(mem_fun(&CutProc::SetMinAmp),v));}
-void	BBCutter::SetMaxAmp(float v)      { for_each(procs.begin(),procs.end(),bind2nd(mem_fun(&CutProc::SetMaxAmp),v));}
-void	BBCutter::SetMinPan(float v)      { for_each(procs.begin(),procs.end(),bind2nd(mem_fun(&CutProc::SetMinPan),v));}
-void	BBCutter::SetMaxPan(float v)      { for_each(procs.begin(),procs.end(),bind2nd(mem_fun(&CutProc::SetMaxPan),v));}
-void	BBCutter::SetDutyCycle(float v)   { for_each(procs.begin(),procs.end(),bind2nd(mem_fun(&CutProc::SetDutyCycle),v));}
-void	BBCutter::SetFillDutyCycle(float v) { for_each(procs.begin(),procs.end(),bind2nd(mem_fun(&CutProc::SetFillDutyCycle),v));}
-void	BBCutter::SetMinDetune(float v)   { for_each(procs.begin(),procs.end(),bind2nd(mem_fun(&CutProc::SetMinDetune),v));}
-void	BBCutter::SetMaxDetune(float v)   { for_each(procs.begin(),procs.end(),bind2nd(mem_fun(&CutProc::SetMaxDetune),v));}
+void	BBCutter::SetMinPhraseLength(long v) { for_each(procs.begin(),procs.end(),bind2nd(mem_fun(&CutProc::SetMinPhraseLength),v)); Replan();}
+void	BBCutter::SetMaxPhraseLength(long v) { for_each(procs.begin(),procs.end(),bind2nd(mem_fun(&CutProc::SetMaxPhraseLength),v)); Replan();}
+void	BBCutter::SetMinAmp(float v)      { for_each(procs.begin(),procs.end(),bind2nd(mem_fun(&CutProc::SetMinAmp),v)); Replan();}
+void	BBCutter::SetMaxAmp(float v)      { for_each(procs.begin(),procs.end(),bind2nd(mem_fun(&CutProc::SetMaxAmp),v)); Replan();}
+void	BBCutter::SetMinPan(float v)      { for_each(procs.begin(),procs.end(),bind2nd(mem_fun(&CutProc::SetMinPan),v)); Replan();}
+void	BBCutter::SetMaxPan(float v)      { for_each(procs.begin(),procs.end(),bind2nd(mem_fun(&CutProc::SetMaxPan),v)); Replan();}
+void	BBCutter::SetDutyCycle(float v)   { for_each(procs.begin(),procs.end(),bind2nd(mem_fun(&CutProc::SetDutyCycle),v)); Replan();}
+void	BBCutter::SetFillDutyCycle(float v) { for_each(procs.begin(),procs.end(),bind2nd(mem_fun(&CutProc::SetFillDutyCycle),v)); Replan();}
+void	BBCutter::SetMinDetune(float v)   { for_each(procs.begin(),procs.end(),bind2nd(mem_fun(&CutProc::SetMinDetune),v)); Replan();}
+void	BBCutter::SetMaxDetune(float v)   { for_each(procs.begin(),procs.end(),bind2nd(mem_fun(&CutProc::SetMaxDetune),v)); Replan();}
 void	BBCutter::SetNumerator(double v)  { numerator   = v; beatsPerBar=4.0*numerator/denominator; UpdateRates();}
 void	BBCutter::SetDenominator(double v) { denominator = v; beatsPerBar=4.0*numerator/denominator; UpdateRates();}
+void	BBCutter::SetSeed(long v)         { state.seed = v; Replan();}
+
+void	BBCutter::SetPlanner(CutPlanner *p)
+{
+  planner = p;
+  Replan();
+}
 
 void	BBCutter::SetSampleRate(double v)
 {
@@ -683,36 +946,131 @@ void	BBCutter::UpdateRates()
 {
 }
 
+long	BBCutter::MaxCutLength()
+{
+  // no cut procedure emits a cut longer than one bar
+  const double beats = std::max(beatsPerBar,kMinBufferBeatsPerBar);
+  return long(std::ceil(SamplesPerBeat(sr,std::min(tempo,kMinTempo))*beats));
+}
+
+long	BBCutter::MaxFadeLength()
+{
+  return long(std::ceil(ms2samples(float(kMaxFade),float(sr))));
+}
+
 void	BBCutter::Phrase(long bar, long sd)
 {
-  barsnow = strategy->ChoosePhraseLength();
+  PlannedCuts *p = NextPlanned();
+  if(p && p->phrase && p->phrasebar==bar && p->subdiv==subdiv)
+  {
+    phraseindex = p->phraseindex;
+    phrasebar = p->phrasebar;
+    barsnow = p->barsnow;
+    UsePlanned(p);
+  }
+  else
+  {
+    Locate(bar);
+    Replan();
+  }
   totalunits = barsnow*subdiv;
   unitsdone = 0;
+  unitsinblock = 0;
+  unitsinsideblock = 0;
   
   listenermanager.OnPhrase(bar,sd);
 }
 
+void	BBCutter::Locate(long bar)
+{
+  // the layout is addressed directly, however far the transport jumps
+  state.LocatePhrase(bar,phraseindex,phrasebar,barsnow);
+}
+
+void	BBCutter::Seek(long bar, long sd, long unit)
+{
+  // replay the blocks of the phrase up to the one in progress at unit,
+  // from the state at the start of the phrase
+  state.PhraseLength(phraseindex);
+  CutList &cuts = player.NextCuts();
+  const double spu = SamplesPerUnit();
+  long start = 0, units = 0;
+  for(;;)
+  {
+    cuts.clear();
+    state.ChooseCuts(cuts,units,phraseindex,start,totalunits,subdiv,spu);
+    if(start+std::max(units,1L)>unit)
+      break;
+    start += std::max(units,1L);
+  }
+  unitsdone = unit;
+  unitsinblock = units;
+  unitsinsideblock = unit-start;
+  player.OnBlock();
+  Replan();
+  
+  listenermanager.OnBlock(phrasebar+start/subdiv,start%subdiv);
+}
+
 void	BBCutter::Block(long bar,long sd)
 {
   unitsinsideblock=0;
-  std::vector<CutInfo> cuts;
-  strategy->ChooseCuts(cuts,unitsinblock,
-                       unitsdone,totalunits,subdiv,SamplesPerUnit());
-  player.OnBlock(cuts);
+  CutList &cuts = player.NextCuts();
+  const double spu = SamplesPerUnit();
+  PlannedCuts *p = NextPlanned();
+  if(p && !p->phrase && p->phraseindex==phraseindex && p->unitsdone==unitsdone &&
+     p->totalunits==totalunits && p->subdiv==subdiv && p->spu==spu)
+  {
+    cuts = p->cuts;
+    unitsinblock = p->unitsinblock;
+    UsePlanned(p);
+  }
+  else
+  {
+    cuts.clear();
+    state.ChooseCuts(cuts,unitsinblock,phraseindex,unitsdone,totalunits,subdiv,spu);
+    Replan();
+  }
+  player.OnBlock();
+  
+  if(snapshotpending)
+    PublishState();
   
   listenermanager.OnBlock(bar,sd);
 }
 
-void	BBCutter::Unit(long bar, long sd)
+PlannedCuts *BBCutter::NextPlanned()
+{
+  return planner ? planner->Front(epoch) : NULL;
+}
+
+void	BBCutter::UsePlanned(PlannedCuts *p)
+{
+  // continue from the state the planner was in after this decision
+  state = p->after;
+  planner->Pop();
+}
+
+void	BBCutter::Replan()
 {
-  if( totalunits<=0 || unitsdone>=totalunits || unitsdone<0 ) //out of phrase bounds and start of a bar
+  // planned decisions no longer follow from our state,
+  // the planner restarts from it after the next block
+  if(planner)
   {
-    if(sd == 0)
-      Phrase(bar,sd);
-    else
-      return;
+    ++epoch;
+    snapshotpending = true;
   }
-  
+}
+
+void	BBCutter::PublishState()
+{
+  if(planner->Publish(epoch,state,phraseindex,phrasebar,
+                      unitsdone,totalunits,unitsinblock,subdiv,SamplesPerUnit()))
+    snapshotpending = false;
+}
+
+void	BBCutter::Unit(long bar, long sd)
+{
   if( unitsinsideblock>=unitsinblock || unitsinsideblock<0) //out of block bounds
     Block(bar,sd);
   
@@ -724,9 +1082,14 @@ void	BBCutter::Unit(long bar, long sd)
 
 void	BBCutter::SetPosition(long bar, long sd)
 {
-  const long delta = sd - (unitsdone % long(UnitsPerBar(subdiv,numerator,denominator)));
-  unitsinsideblock += delta;
-  unitsdone += delta;
+  // the decisions only depend on the position, jumps rebuild them from the phrase start
+  if(totalunits<=0 || bar<phrasebar || bar>=phrasebar+barsnow) //out of phrase bounds
+    Phrase(bar,sd);
+  
+  const long unit = (bar-phrasebar)*subdiv + sd;
+  if(unit!=unitsdone)
+    Seek(bar,sd,unit);
+  
   Unit(bar,sd);
 }
 
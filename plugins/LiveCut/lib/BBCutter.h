@@ -24,43 +24,139 @@
 #include <vector>
 #include <cmath>
 #include <cstdlib>
+#include <stdint.h>
 #include <algorithm>
 #include <numeric>
 
 //-------------------------------------------------------------------------------
-struct Math
+/**
+ @brief small per-instance random generator (PCG32)
+ 
+ each instance owns its state, so instances don't share a lock and a seed
+ reproduces the same sequence whatever the other instances do.
+ streams let several generators share a seed without being correlated.
+ */
+class Random
 {
-	static inline long  randominteger(long min, long max)
+public:
+  Random(uint64_t s=1, uint64_t stream=0) { seed(s,stream); }
+  
+  inline void seed(uint64_t s, uint64_t stream=0)
+  {
+    state = 0;
+    inc = (stream<<1u) | 1u;
+    next();
+    state += s;
+    next();
+  }
+  
+  inline uint32_t next()
+  {
+    const uint64_t old = state;
+    state = old*6364136223846793005ULL + inc;
+    const uint32_t xorshifted = uint32_t(((old>>18u)^old)>>27u);
+    const uint32_t rot = uint32_t(old>>59u);
+    return (xorshifted>>rot) | (xorshifted<<((32u-rot)&31u));
+  }
+  
+	inline long  randominteger(long min, long max)
 	{
     return long(0.5000001+randomfloat(min,max));
   }
 	
-	static inline double randomfloat(double min , double max)
+	inline double randomfloat(double min , double max)
 	{
-    return min + (max-min)*double(rand())/double(RAND_MAX);
+    return min + (max-min)*double(next())*(1.0/4294967295.0);
   }
   
-  static inline void randomseed(long seed)
+  // hash of a position (SplitMix64 finalizer), to seed a generator per decision
+  // so that any decision can be redrawn without replaying the ones before it
+  static inline uint64_t key(uint64_t s, uint64_t a, uint64_t b)
   {
-    srand(seed);
+    return mix(mix(mix(s)^a)^b);
   }
   
-  template<class T>
-  static inline T wchoose(T *values,double *weights,long size)
+private:
+  static inline uint64_t mix(uint64_t z)
   {
-    std::vector<double> cumsum(size);
-    cumsum[0] = *weights;
-    for(int i=1;i<cumsum.size();++i)
-      cumsum[i] = cumsum[i-1] + weights[i];
+    z += 0x9e3779b97f4a7c15ULL;
+    z = (z^(z>>30))*0xbf58476d1ce4e5b9ULL;
+    z = (z^(z>>27))*0x94d049bb133111ebULL;
+    return z^(z>>31);
+  }
+  
+private:
+  uint64_t state;
+  uint64_t inc;
+};
+
+//-------------------------------------------------------------------------------
+/**
+ @brief weighted choice between N fixed values (Walker's alias method)
+ 
+ the table is built once from the weights, each draw then costs one random
+ number and no allocation.
+ */
+template<class T, long N>
+class WeightedChoice
+{
+public:
+  WeightedChoice(const T *v, const double *weights)
+  {
+    double sum = 0.0;
+    for(long i=0;i<N;++i)
+      sum += weights[i];
     
-    double v = randomfloat(0.0,cumsum.back());
-    long index;
-    for(index=0;index<size;++index)
-      if(v<cumsum[index])
-        break;
-    return values[index];
+    double scaled[N];
+    long small[N], large[N];
+    long nsmall = 0, nlarge = 0;
+    for(long i=0;i<N;++i)
+    {
+      values[i] = v[i];
+      alias[i] = i;
+      scaled[i] = weights[i]*double(N)/sum;
+      if(scaled[i]<1.0)
+        small[nsmall++] = i;
+      else
+        large[nlarge++] = i;
+    }
+    
+    while(nsmall>0 && nlarge>0)
+    {
+      const long s = small[--nsmall];
+      const long l = large[nlarge-1];
+      prob[s] = scaled[s];
+      alias[s] = l;
+      scaled[l] -= 1.0-scaled[s];
+      if(scaled[l]<1.0)
+      {
+        --nlarge;
+        small[nsmall++] = l;
+      }
+    }
+    // leftovers are 1 up to rounding
+    while(nlarge>0)
+      prob[large[--nlarge]] = 1.0;
+    while(nsmall>0)
+      prob[small[--nsmall]] = 1.0;
   }
-	
+  
+  inline T choose(Random &rng) const
+  {
+    const double v = rng.randomfloat(0.0,double(N));
+    const long index = std::min(long(v),N-1);
+    return (v-double(index)) < prob[index] ? values[index] : values[alias[index]];
+  }
+  
+private:
+  T values[N];
+  double prob[N];
+  long alias[N];
+};
+
+//-------------------------------------------------------------------------------
+struct Math
+{
   static inline float clip(const float x,const float mn,const float mx)
   {
     return std::min(std::max(x,mn),mx);
@@ -69,6 +165,12 @@ struct Math
 
 static const float pi_4 = atan(1.f);
 
+// slowest tempo and shortest bar (in quarter notes) the player buffers are sized for
+static const double kMinTempo = 40.0;
+static const double kMinBufferBeatsPerBar = 4.0;
+// longest fade (LVC_FADE's upper limit, in ms) the envelope table is sized for
+static const double kMaxFade = 100.0;
+
 struct CutInfo
 {
 	long size;
@@ -82,6 +184,59 @@ struct CutInfo
 	CutInfo();
 };
 
+/**
+ @brief bounded list of cuts with inline storage
+ 
+ cut procedures fill it in place, so choosing a block of cuts never touches
+ the heap. the longest sequence is an end of phrase stutter: less than
+ one bar of units (at most 31 with subdiv 32) times a multiplier of 8.
+ */
+class CutList
+{
+public:
+  enum { kMaxCuts = 256 };
+  
+  CutList() : count(0) {}
+  
+  // only the cuts in use are copied, usually a handful out of kMaxCuts
+  CutList(const CutList &other) : count(other.count)
+  {
+    std::copy(other.cuts,other.cuts+other.count,cuts);
+  }
+  
+  inline CutList &operator=(const CutList &other)
+  {
+    if(this!=&other)
+    {
+      std::copy(other.cuts,other.cuts+other.count,cuts);
+      count = other.count;
+    }
+    return *this;
+  }
+  
+  inline void clear() { count = 0; }
+  
+  // like std::vector::resize, new cuts get default values, n is clamped to kMaxCuts
+  inline void resize(long n)
+  {
+    n = std::min(std::max(n,0L),long(kMaxCuts));
+    for(long i=count;i<n;++i)
+      cuts[i] = CutInfo();
+    count = n;
+  }
+  
+  inline long size() const { return count; }
+  inline bool empty() const { return count==0; }
+  inline CutInfo &operator[](long i) { return cuts[i]; }
+  inline const CutInfo &operator[](long i) const { return cuts[i]; }
+  inline CutInfo *begin() { return cuts; }
+  inline CutInfo *end() { return cuts+count; }
+  
+private:
+  CutInfo cuts[kMaxCuts];
+  long count;
+};
+
 enum CutId
 {
   kCutProc11=0,
@@ -110,9 +265,10 @@ public:
 	void SetFillDutyCycle(float v);
   void SetMinPhraseLength(long v);
   void SetMaxPhraseLength(long v);
+  void SetRandom(Random *r);
   
   virtual long ChoosePhraseLength();
-  virtual void ChooseCuts(std::vector<CutInfo> &cuts,
+  virtual void ChooseCuts(CutList &cuts,
                           long &unitsinblock,
                           long unitsdone,
                           long totalunits,
@@ -122,6 +278,7 @@ public:
 protected:
   float minamp,maxamp,minpan,maxpan,mindetune,maxdetune,dutycycle,filldutycycle;
   long maxphraselength,minphraselength;
+  Random *rng;
 };
 
 //-------------------------------------------------------------------------------
@@ -135,7 +292,7 @@ public:
 	void SetMinRepeats(long v);
 	void SetMaxRepeats(long v);
   
-	void ChooseCuts(std::vector<CutInfo> &cuts,
+	void ChooseCuts(CutList &cuts,
                   long &unitsinblock,
                   long unitsdone,
                   long totalunits,
@@ -149,6 +306,7 @@ private:
 private:
 	float stutterchance,stutterarea;
 	long minrepeats, maxrepeats;
+  WeightedChoice<long,6> stuttermultipliers;
 };
 
 //-------------------------------------------------------------------------------
@@ -162,7 +320,7 @@ public:
 	void SetRitardChance(float chance);
 	void SetAccel(float v);
   
-	void ChooseCuts(std::vector<CutInfo> &cuts,
+	void ChooseCuts(CutList &cuts,
                   long &unitsinblock,
                   long unitsdone,
                   long totalunits,
@@ -174,6 +332,7 @@ public:
   
 private:
 	float straightchance, regularchance, ritardchance, accel;
+  WeightedChoice<long,3> blocksizes;
 };
 
 //-------------------------------------------------------------------------------
@@ -185,7 +344,7 @@ public:
   
   
   long ChoosePhraseLength();
-	void ChooseCuts(std::vector<CutInfo> &cuts,
+	void ChooseCuts(CutList &cuts,
                   long &unitsinblock,
                   long unitsdone,
                   long totalunits,
@@ -193,14 +352,52 @@ public:
                   double spu);
 
 private:
-  void sqpusherinit();
+  typedef std::vector< std::vector< std::vector<double> > > CutSequence;
+  static CutSequence sqpusherinit();
+  static const CutSequence &sequences();
 
 private:
-  typedef std::vector< std::vector< std::vector<double> > > CutSequence;
   double activity;
   bool fill;
   long fillnumber,fillpos;
-  CutSequence cs;
+};
+
+//-------------------------------------------------------------------------------
+/**
+ @brief everything the cut decisions depend on, apart from the position
+ 
+ the generator is reseeded from (seed,phrase,unit) before each decision.
+ the procs of a copy draw from the copy's own generator, so a copy can run
+ ahead of the cutter (see CutPlanner) and be handed back to it.
+ */
+struct CutState
+{
+  CutState();
+  CutState(const CutState &other);
+  CutState &operator=(const CutState &other);
+  
+  CutProc *Strategy();
+  // length in bars drawn for the phrase with this index
+  long PhraseLength(long phrase);
+  
+  // phrases are laid out in groups of kPhraseGroupBars bars from bar 0, the last
+  // phrase of a group cut short to fit, so that any bar is found in a few draws
+  enum { kPhraseGroupBars = 8 };
+  // index, first bar and length of the phrase holding bar, the state is left
+  // at the start of that phrase
+  void LocatePhrase(long bar, long &phrase, long &start, long &length);
+  void ChooseCuts(CutList &cuts, long &unitsinblock,
+                  long phrase, long unitsdone, long totalunits, long subdiv, double spu);
+  
+  CutProc11 cutproc11;
+  WarpCutProc warpcutproc;
+  SQPusherCutProc sqpusher;
+  Random rng;
+  long strategy;
+  long seed;
+  
+private:
+  void Bind();
 };
 
 //-------------------------------------------------------------------------------
@@ -243,36 +440,59 @@ static float trapeze(long i,long fade, long size)
   return float(env)/float(fade);
 }
 
-static float expenv(float i,float fade,float size)
-{
-  return (1-exp(-5*i/fade)) * (1-exp(5*(i-size)/fade));
-}
-
 class LivePlayer
 {
 public:
 	LivePlayer();
 	void SetListenerManager(ListenerManager *lm);
   void SetFade(float v);
-  void OnBlock(std::vector<CutInfo> newcuts);
+  // maxfade in samples, longer fades are cut short
+  void SetMaxCutLength(long v, long maxfade);
+  
+  // gain of sample i of a cut of the given length, tabulated
+  // (1-exp(-5*i/fade)) * (1-exp(5*(i-length)/fade)) for 0<=i<length
+  inline float envelope(long i, long length) const
+  {
+    return envtable[std::min(i,fadelength)] * envtable[std::min(length-i,fadelength)];
+  }
+  
+  // list for the next block, filled by the cutter before calling OnBlock()
+  inline CutList &NextCuts() { return *nextcuts; }
+  // swaps in the next cuts, an empty list keeps the current ones playing
+  void OnBlock();
+  // the current cut is resampled
+  inline bool IsPitched() const { return pitched; }
 
   inline bool tick(float &outL, float &outR,const float inL,const float inR)
   {
-    if(currentcut<cuts.size())
+    if(currentcut<cuts->size())
     {
-      if(inputindex<inputbufferL.size()) //store input
+      if(inputindex<blocklength) //store input
       {
         inputbufferL[inputindex] = inL;
         inputbufferR[inputindex] = inR;
         inputindex++;
       }
       
-      if(readindex<cuts[currentcut].length) //dutycycle on
+      if(readindex<(*cuts)[currentcut].length) //dutycycle on
       {
-        const float l = (*L)[readindex];
-        const float r = (*R)[readindex];
+        float l,r;
+        if(pitched)
+        {
+          // resample on the fly, one interpolated read per output sample
+          const double p = double(readindex)*ratio;
+          const long pos = long(p);
+          const float frac = float(p-double(pos));
+          l = captured(inputbufferL,pos)*(1-frac) + captured(inputbufferL,pos+1)*frac;
+          r = captured(inputbufferR,pos)*(1-frac) + captured(inputbufferR,pos+1)*frac;
+        }
+        else
+        {
+          l = inputbufferL[readindex];
+          r = inputbufferR[readindex];
+        }
         //rotation matrix
-        const float env = expenv(readindex,fade,cuts[currentcut].length);
+        const float env = envelope(readindex,(*cuts)[currentcut].length);
         
         outL = env*(ll*l + rl*r);
         outR = env*(lr*l + rr*r);
@@ -285,45 +505,14 @@ public:
         outR = 0.f;
       }
       
-      if(readindex>=cuts[currentcut].size) //end of cut
+      if(readindex>=(*cuts)[currentcut].size) //end of cut
       {
-        currentcut++;
-        readindex = 0;
-        if(currentcut>=cuts.size())
+        if(!NextCut())
         {
           outL = 0.f;
           outR = 0.f;
           return false;
         }
-				const float amp = cuts[currentcut].amp;
-				const float pan = cuts[currentcut].pan;
-        ll = amp * ((pan<0)? 1.f :  cos(pan*2*pi_4));
-        lr = amp * ((pan<0)? 0.f :  sin(pan*2*pi_4));
-        rl = amp * ((pan>0)? 0.f : -sin(pan*2*pi_4));
-        rr = amp * ((pan>0)? 1.f :  cos(pan*2*pi_4));
-        
-        if(fabs(cuts[currentcut].cents) > 1e-10)
-        {
-          //resample
-          const double ratio = pow(2.f,cuts[currentcut].cents/1200.f);
-          const long sz = std::min(   long(pitchedbufferL.size()),
-                                   (long(double(inputbufferL.size())/ratio)-1));
-          for(int i=0;i<sz;++i)
-          {
-            const long pos = long(float(i)*ratio);
-            const float frac = float(i)*ratio-float(pos);
-            const float a = inputbufferL[pos]*(1-frac)+inputbufferL[pos+1]*frac;
-            const float b = inputbufferR[pos]*(1-frac)+inputbufferR[pos+1]*frac;
-            pitchedbufferL[i] = a;
-            pitchedbufferR[i] = b;
-          }
-          L = &pitchedbufferL;
-          R = &pitchedbufferR;
-        }
-        // tell cut-synchrone effects
-        if(listenermanager)
-          listenermanager->OnCut(currentcut,cuts.size()); // allow interpolation...
-        
         return true;
       }
     }
@@ -336,21 +525,44 @@ public:
 		return false;
   }
   
+  /*
+   block version of tick(), returns the number of samples processed.
+   it stops at the end of each cut and only moves to the next one (and
+   notifies the listeners) on the following call, so that cut-synchrone
+   effects can process each span with the parameters of its own cut.
+   */
+  long process(const float *inL, const float *inR, float *outL, float *outR, long n);
+  
+private:
+  bool NextCut();
+  void UpdateEnvelope();
+  
+  inline float captured(const std::valarray<float> &buffer, long i) const
+  {
+    return (i<pitchlimit) ? buffer[i] : 0.f;
+  }
+  
 private:
 	std::valarray<float> inputbufferL;
 	std::valarray<float> inputbufferR;
-	std::valarray<float> pitchedbufferL;
-	std::valarray<float> pitchedbufferR;
-	std::valarray<float> *L;
-	std::valarray<float> *R;
+  std::vector<float> envtable;
+  long fadelength;
+  bool pitched;
+  double ratio;
+  long pitchlimit;
   long currentcut;
+  long maxcutlength,blocklength;
   long inputindex,readindex;
   float ll,lr,rl,rr;
   long fade;
-  std::vector<CutInfo> cuts;
+  CutList cutlists[2];
+  CutList *cuts,*nextcuts;
 	ListenerManager *listenermanager;
 };
 
+class CutPlanner;
+struct PlannedCuts;
+
 //------------------------------------------------------------------------------------------------
 inline float ms2samples(float t,float sr)
 {
@@ -391,6 +603,9 @@ public:
 	void	SetMaxDetune(float v);
 	void	SetNumerator(double v);
 	void	SetDenominator(double v);
+	void	SetSeed(long v);
+  // plan the cuts ahead on the planner's thread, NULL to decide them synchronously
+  void	SetPlanner(CutPlanner *p);
 	
   void	SetSampleRate(double v);
 	void	SetTimeInfos(double bpm,double num,double den,double srate);
@@ -402,12 +617,22 @@ public:
 	inline double SamplesPerBeat(double sr,double tempo) { return sr/BeatsPerSecond(tempo);}
 	inline double SamplesPerBar() { return SamplesPerBeat(sr,tempo)*beatsPerBar;}
 	inline double SamplesPerUnit() { return SamplesPerBar()/double(subdiv);}
+	long	MaxCutLength();
+	long	MaxFadeLength();
   
 	void	Phrase(long bar, long sd);
   void	Block(long bar,long sd);
   void	Unit(long bar, long sd);
 	void	SetPosition(long bar, long sd);
   
+private:
+  void	Locate(long bar);
+  void	Seek(long bar, long sd, long unit);
+  PlannedCuts *NextPlanned();
+  void	UsePlanned(PlannedCuts *p);
+  void	Replan();
+  void	PublishState();
+  
 private:
 	// params
 	double	tempo, sr;
@@ -417,12 +642,13 @@ private:
 	// states
 	long	unitsdone, totalunits, barsnow,
   unitsinblock, unitsinsideblock,	barsinsample,slicestart;
+	long	phraseindex, phrasebar;
   
-	CutProc11 cutproc11;
-	WarpCutProc warpcutproc;
-	SQPusherCutProc sqpusher;
-	CutProc	*strategy;
+	CutState state;
   std::vector<CutProc *> procs;
+	CutPlanner *planner;
+	long	epoch;
+	bool	snapshotpending;
 	ListenerManager listenermanager;
 	LivePlayer	&player;
 };
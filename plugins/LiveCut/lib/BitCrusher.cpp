@@ -18,6 +18,14 @@
  */
 
 #include "BitCrusher.h"
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__SSE4_1__)
+#include <smmintrin.h>
+#endif
 
 BitCrusher::BitCrusher()
 : minbits(32)
@@ -31,31 +39,212 @@ BitCrusher::BitCrusher()
 , startfreq(44100)
 , endfreq(44100)
 , sr(44100)
-, lag(1.f)
-, count(0.f)
+, lag(kOne)
+, count(0)
 , memory1(0.f)
 , memory2(0.f)
 , on(true)
+, rng(1,1)
+, seed(1)
+, hasblock(false)
+, cuthasblock(false)
+, missedblock(false)
+, missedcut(false)
+, lastbar(0)
+, lastsd(0)
+, lastcut(0)
+, lastnumcuts(0)
+, cutbar(0)
+, cutsd(0)
 {
 }
 
 void BitCrusher::OnBlock(long bar, long sd)
 {
-  startbits = Math::randomfloat(minbits,maxbits);
-  endbits = Math::randomfloat(minbits,maxbits);
+  hasblock = true;
+  lastbar = bar;
+  lastsd = sd;
+  if(!on)
+  {
+    missedblock = true;
+    return;
+  }
+  
+  // drawn from the block position only, like the cuts
+  rng.seed(Random::key(seed,bar,sd),1);
+  startbits = rng.randomfloat(minbits,maxbits);
+  endbits = rng.randomfloat(minbits,maxbits);
   
-  startfreq = Math::randomfloat(minfreq,maxfreq);
-  endfreq = Math::randomfloat(minfreq,maxfreq);
+  startfreq = rng.randomfloat(minfreq,maxfreq);
+  endfreq = rng.randomfloat(minfreq,maxfreq);
 }
 
 void BitCrusher::OnCut(long cut, long numcuts)
 {
+  lastcut = cut;
+  lastnumcuts = numcuts;
+  cuthasblock = hasblock;
+  cutbar = lastbar;
+  cutsd = lastsd;
+  if(!on)
+  {
+    missedcut = true;
+    return;
+  }
+  
   float bits = startbits + (float(cut)/float(numcuts))*endbits;
   multiplier = pow(2.f,bits);
   divider = 1.f/multiplier;
   
   float freq = startfreq + (float(cut)/float(numcuts))*endfreq;
-  lag = sr/freq;
+  lag = std::max<uint64_t>(1, uint64_t(double(sr/freq)*double(kOne)));
+}
+
+#if defined(__SSE2__)
+static inline __m128 floor_ps(__m128 v)
+{
+#if defined(__SSE4_1__)
+  return _mm_floor_ps(v);
+#else
+  const __m128 sign = _mm_set1_ps(-0.f);
+  // truncate and step down the negative ones, from 2^23 up floats are whole
+  // numbers already (and too big for an int past 2^31)
+  __m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(v));
+  t = _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t,v), _mm_set1_ps(1.f)));
+  t = _mm_or_ps(t, _mm_and_ps(v,sign)); // keep -0
+  const __m128 whole = _mm_cmpge_ps(_mm_andnot_ps(sign,v), _mm_set1_ps(8388608.f));
+  return _mm_or_ps(_mm_and_ps(whole,v), _mm_andnot_ps(whole,t));
+#endif
+}
+#endif
+
+/**
+  floor(x*multiplier)*divider, 4 samples at a time where SSE is available.
+*/
+static void quantize(float *x, long n, float multiplier, float divider)
+{
+  long i=0;
+#if defined(__SSE2__)
+  const __m128 m = _mm_set1_ps(multiplier);
+  const __m128 d = _mm_set1_ps(divider);
+  for(;i+4<=n;i+=4)
+    _mm_storeu_ps(x+i, _mm_mul_ps(floor_ps(_mm_mul_ps(_mm_loadu_ps(x+i),m)),d));
+#endif
+  for(;i<n;i++)
+    x[i] = floor(x[i]*multiplier)*divider;
+}
+
+/**
+  The same for one stereo sample.
+*/
+static inline void quantize(float &l, float &r, float multiplier, float divider)
+{
+#if defined(__SSE2__)
+  float lr[4];
+  const __m128 v = _mm_mul_ps(_mm_setr_ps(l,r,0.f,0.f),_mm_set1_ps(multiplier));
+  _mm_storeu_ps(lr, _mm_mul_ps(floor_ps(v),_mm_set1_ps(divider)));
+  l = lr[0];
+  r = lr[1];
+#else
+  l = floor(l*multiplier)*divider;
+  r = floor(r*multiplier)*divider;
+#endif
+}
+
+static inline void fill(float *x, long n, float v)
+{
+  long i=0;
+#if defined(__SSE2__)
+  const __m128 v4 = _mm_set1_ps(v);
+  for(;i+4<=n;i+=4)
+    _mm_storeu_ps(x+i,v4);
+#endif
+  for(;i<n;i++)
+    x[i] = v;
+}
+
+/**
+  Go from one hold point to the next and fill the samples in between with the
+  held value. The clock counts in fixed point, so the distance to the next
+  hold point is known without stepping through the samples. Faster than the
+  sample rate every sample is a hold point and the span is just quantized.
+  Close hold points are written without a loop per hold, whose length would
+  change from one to the next.
+*/
+void BitCrusher::process(float *L, float *R, long n)
+{
+  long i=0;
+  while(i<n)
+  {
+    if(count<=lag)
+    {
+      // held until the clock gets above lag
+      const long run = long(std::min<uint64_t>(((lag-count)>>32)+1, uint64_t(n-i)));
+      fill(L+i,run,memory1);
+      fill(R+i,run,memory2);
+      count += uint64_t(run)<<32;
+      i += run;
+    }
+    else if(lag<=kOne)
+    {
+      quantize(L+i,n-i,multiplier,divider);
+      quantize(R+i,n-i,multiplier,divider);
+      count = wrap(count+uint64_t(n-i-1)*kOne,lag)+kOne;
+      memory1 = L[n-1];
+      memory2 = R[n-1];
+      return;
+    }
+    else if(lag<kDense && i+kDenseRun<=n)
+    {
+      // hold points a few samples apart. Find a batch of them and read their
+      // inputs first, then write each held sample over the kDenseRun samples
+      // a hold can last, the next hold point overwriting the extra ones.
+      // Past the last one the input is put back for the next batch
+      long at[kBatch];
+      float l[kBatch], r[kBatch], restl[kDenseRun], restr[kDenseRun];
+      // the time held after a hold point, its whole samples make the run and
+      // the fraction carries over to the next hold along with lag
+      uint64_t left = lag-wrap(count,lag);
+      long m = 0, run = 0;
+      while(m<kBatch && i+kDenseRun<=n)
+      {
+        at[m] = i;
+        l[m] = L[i];
+        r[m] = R[i];
+        m++;
+        run = long(left>>32)+1;
+        i += run;
+        left = (left&(kOne-1))+lag-kOne;
+      }
+      quantize(l,m,multiplier,divider);
+      quantize(r,m,multiplier,divider);
+      const long last = at[m-1];
+      std::memcpy(restl,L+last,sizeof(restl));
+      std::memcpy(restr,R+last,sizeof(restr));
+      // shorter holds need half the writes
+      const long width = (lag<=kOne*(kDenseRun/2)) ? kDenseRun/2 : kDenseRun;
+      for(long k=0;k<m;k++)
+      {
+        fill(L+at[k],width,l[k]);
+        fill(R+at[k],width,r[k]);
+      }
+      std::memcpy(L+last,restl,sizeof(restl));
+      std::memcpy(R+last,restr,sizeof(restr));
+      fill(L+last,run,l[m-1]);
+      fill(R+last,run,r[m-1]);
+      count = 2*lag-left;
+      memory1 = l[m-1];
+      memory2 = r[m-1];
+    }
+    else
+    {
+      quantize(L[i],R[i],multiplier,divider);
+      memory1 = L[i];
+      memory2 = R[i];
+      count = wrap(count,lag)+kOne;
+      i++;
+    }
+  }
 }
 
 // 0 - 32
@@ -67,4 +256,30 @@ void BitCrusher::SetMaxFreqFromNormalized(float v){maxfreq = v*sr;}
 void BitCrusher::SetMinFreq(float v){minfreq = v;}
 void BitCrusher::SetMaxFreq(float v){maxfreq = v;}
 void BitCrusher::SetSampleRate(float v){sr = v;}
-void BitCrusher::SetOn(bool v){on = v;}
+void BitCrusher::SetOn(bool v)
+{
+  const bool wason = on;
+  on = v;
+  
+  if(on && !wason)
+    CatchUp();
+}
+
+/**
+  Draw again what the listener calls skipped while off, in the order they came.
+*/
+void BitCrusher::CatchUp()
+{
+  const bool redoblock = missedblock || (missedcut && cuthasblock);
+  const long bar = lastbar, sd = lastsd;
+  if(missedcut)
+  {
+    if(cuthasblock)
+      OnBlock(cutbar,cutsd);
+    OnCut(lastcut,lastnumcuts);
+  }
+  if(redoblock)
+    OnBlock(bar,sd);
+  missedblock = missedcut = false;
+}
+void BitCrusher::SetSeed(long v){seed = v;}
@@ -48,6 +48,8 @@ public:
 	void SetMaxFreq(float v);
 	void SetSampleRate(float v);
 	void SetOn(bool v);
+	void SetSeed(long v);
+	inline bool IsOn() const {return on;}
   
 	inline void tick(float &out1,float &out2, const float in1, const float in2)
 	{
@@ -59,10 +61,9 @@ public:
 				// but eh it's a bitcrusher!
 				memory1 = floor(in1*multiplier)*divider;
 				memory2 = floor(in2*multiplier)*divider;
-				while(count>lag) 
-					count -= lag;
+				count = wrap(count,lag);
 			}
-			count += 1.f;
+			count += kOne;
 			out1 = memory1;
 			out2 = memory2;
 		} // if(on)
@@ -73,14 +74,40 @@ public:
 		}
 	}
   
+	// block version of tick, in place and whether on or not: the caller leaves
+	// the crusher out of the chain while it's off. Same output as tick.
+	void process(float *L, float *R, long n);
+  
 private:
+	// the sample-and-hold clock counts samples in 32.32 fixed point
+	static const uint64_t kOne = uint64_t(1)<<32;
+	// below this lag a hold lasts at most kDenseRun samples, and process finds
+	// the hold points kBatch at a time before writing them
+	static const long kDenseRun = 8;
+	static const uint64_t kDense = kDenseRun*kOne;
+	static const long kBatch = 32;
+  
+	// subtract lag until count is back in (0,lag]
+	static inline uint64_t wrap(uint64_t count, uint64_t lag)
+	{
+		return (count-lag<=lag) ? count-lag : (count-1)%lag+1;
+	}
+  
 	float minbits,maxbits,startbits,endbits;
 	float multiplier,divider;
 	float minfreq,maxfreq,startfreq,endfreq;
 	float sr;
-	float lag,count;
+	uint64_t lag,count;
 	float memory1,memory2;
 	bool on;
+	Random rng;
+	long seed;
+	// the last block and cut, replayed when switched on if they were missed.
+	// The player announces the first cut of a block before the block itself,
+	// so the cut keeps the block it is computed with
+	void CatchUp();
+	bool hasblock,cuthasblock,missedblock,missedcut;
+	long lastbar,lastsd,lastcut,lastnumcuts,cutbar,cutsd;
 };
 
 #endif
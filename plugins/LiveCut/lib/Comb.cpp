@@ -18,39 +18,292 @@
  */
 
 #include "Comb.h"
+#include <cmath>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+const float Comb::kMaxDelay = 50.f;
+
+namespace {
+
+// the feedforward path works through the block in chunks of at most kChunk samples
+const long kChunk = 64;
+
+// closer than this to its target the smoothed delay is held constant
+const float kSettled = 1e-3f; //samples
+
+// where the delay line is read, point j is the frame back+j behind
+// the one just written, and with which weights, for both channels
+struct Tap
+{
+  long back;
+  float h[4];
+};
+
+template<long interpolation> inline void design(float d, Tap &tap);
+
+// same rounding as linear_interpolation() in DelayLine.h
+template<> inline void design<Comb::Linear>(float d, Tap &tap)
+{
+  const long k = round_to_int(-d);
+  const float frac = -d - float(k);
+  tap.back = -(k+1);
+  tap.h[0] = frac;
+  tap.h[1] = 1.f-frac;
+}
+
+// first order allpass, the fractional part is kept in [0.5,1.5) where
+// the coefficient stays small
+template<> inline void design<Comb::Allpass>(float d, Tap &tap)
+{
+  const long m = long(d-0.5f);
+  const float frac = d - float(m);
+  tap.back = m;
+  tap.h[0] = (1.f-frac)/(1.f+frac);
+}
+
+// four points around the delay, with the fractional part in [1,2)
+template<> inline void design<Comb::Lagrange>(float d, Tap &tap)
+{
+  const long m = long(d);
+  const float x = d - float(m) + 1.f;
+  tap.back = m-1;
+  tap.h[0] = -(x-1.f)*(x-2.f)*(x-3.f)*(1.f/6.f);
+  tap.h[1] = x*(x-2.f)*(x-3.f)*0.5f;
+  tap.h[2] = -x*(x-1.f)*(x-3.f)*0.5f;
+  tap.h[3] = x*(x-1.f)*(x-2.f)*(1.f/6.f);
+}
+
+template<long points>
+inline void weigh(const StereoDelayLine &dl, const Tap &tap, float &L, float &R)
+{
+  // from the oldest point, the others follow it
+  const float *oldest = dl.tap(tap.back+points);
+#if defined(__SSE2__)
+  __m128 y = _mm_setzero_ps();
+  for(long j=0;j<points;j++)
+  {
+    const __m128 frame = _mm_loadl_pi(_mm_setzero_ps(), (const __m64*)(oldest+2*(points-1-j)));
+    y = _mm_add_ps(y, _mm_mul_ps(_mm_set1_ps(tap.h[j]), frame));
+  }
+  L = _mm_cvtss_f32(y);
+  R = _mm_cvtss_f32(_mm_shuffle_ps(y, y, _MM_SHUFFLE(1,1,1,1)));
+#else
+  float l = 0.f, r = 0.f;
+  for(long j=0;j<points;j++)
+  {
+    const float *frame = oldest+2*(points-1-j);
+    l += tap.h[j]*frame[0];
+    r += tap.h[j]*frame[1];
+  }
+  L = l;
+  R = r;
+#endif
+}
+
+// L and R hold the previous read, which the allpass feeds back
+template<long interpolation>
+inline void read(const StereoDelayLine &dl, const Tap &tap, float &L, float &R)
+{
+  if(interpolation==Comb::Linear)
+    weigh<2>(dl,tap,L,R);
+  else if(interpolation==Comb::Lagrange)
+    weigh<4>(dl,tap,L,R);
+  else
+  {
+    const float *frame1 = dl.tap(tap.back+2);
+    const float *frame0 = frame1+2;
+    L = tap.h[0]*(frame0[0]-L) + frame1[0];
+    R = tap.h[0]*(frame0[1]-R) + frame1[1];
+  }
+}
+
+}
+
 
 Comb::Comb()
 : mindelay(50)
 , maxdelay(50)
 , startdelay(50)
 , enddelay(50)
-, feedback(0.5)
-, type(FeedForward) //feedforward
+, dl(2205,0,DelayLine::Exact) // sized by AllocateDelays()
+, lastL(0)
+, lastR(0)
 , sr(44100)
+, allocatedsr(0)
+, feedback(0.5)
 , delay(2205)
-, dl1(2205,44100)
-, dl2(2205,44100) // 50 ms
-, on(true)
+, on(false)
+, type(FeedForward) //feedforward
+, interpolation(Linear)
+, rng(1,2)
+, seed(1)
+, hasblock(false)
+, cuthasblock(false)
+, missedblock(false)
+, missedcut(false)
+, lastbar(0)
+, lastsd(0)
+, lastcut(0)
+, lastnumcuts(0)
+, cutbar(0)
+, cutsd(0)
 {
   lp.SetSampleRate(44100);
   lp.SetTimeConstant(40.f); //40 ms
   lp.SetState(50.f);
+  AllocateDelays();
 }
 
 void Comb::OnBlock(long bar, long sd)
 {
-  startdelay = Math::randomfloat(mindelay,maxdelay);
-  enddelay = Math::randomfloat(mindelay,maxdelay);
+  hasblock = true;
+  lastbar = bar;
+  lastsd = sd;
+  if(!on)
+  {
+    missedblock = true;
+    return;
+  }
+  
+  // drawn from the block position only, like the cuts
+  rng.seed(Random::key(seed,bar,sd),2);
+  startdelay = rng.randomfloat(mindelay,maxdelay);
+  enddelay = rng.randomfloat(mindelay,maxdelay);
 }
 
 void Comb::OnCut(long cut, long numcuts)
 {
+  lastcut = cut;
+  lastnumcuts = numcuts;
+  cuthasblock = hasblock;
+  cutbar = lastbar;
+  cutsd = lastsd;
+  if(!on)
+  {
+    missedcut = true;
+    return;
+  }
+  
   delay = (startdelay + (float(cut)/float(numcuts))*enddelay)*sr/1000.f;
+}
+
+void Comb::tick(float &out1, float &out2, const float in1, const float in2)
+{
+  if(!on)
+  {
+    out1 = in1;
+    out2 = in2;
+  }
+  else if(type==FeedForward) // feedforward
+  {
+    dl.set_delay(delay);
+    dl.tick(lastL,lastR,in1,in2);
+    out1 = 0.5f*(in1+lastL);
+    out2 = 0.5f*(in2+lastR);
+  }
+  else if(interpolation==Allpass)
+    TickFeedBack<Allpass>(out1,out2,in1,in2);
+  else if(interpolation==Lagrange)
+    TickFeedBack<Lagrange>(out1,out2,in1,in2);
+  else
+    TickFeedBack<Linear>(out1,out2,in1,in2);
+}
+
+void Comb::process(float *L, float *R, long n)
+{
   if(type==FeedForward) // feedforward
+    ProcessFeedForward(L,R,n);
+  else if(interpolation==Allpass)
+    ProcessFeedBack<Allpass>(L,R,n);
+  else if(interpolation==Lagrange)
+    ProcessFeedBack<Lagrange>(L,R,n);
+  else
+    ProcessFeedBack<Linear>(L,R,n);
+}
+
+void Comb::ProcessFeedForward(float *L, float *R, long n)
+{
+  // the delay only changes on cuts, so the line runs a block at a time
+  float yL[kChunk], yR[kChunk];
+  dl.set_delay(delay);
+  for(long i=0;i<n;i+=kChunk)
+  {
+    const long m = std::min(kChunk,n-i);
+    dl.tick(L+i,R+i,yL,yR,m);
+    for(long j=0;j<m;j++)
+    {
+      L[i+j] = 0.5f*(L[i+j]+yL[j]);
+      R[i+j] = 0.5f*(R[i+j]+yR[j]);
+    }
+  }
+  lastL = dl.lastOutL();
+  lastR = dl.lastOutR();
+}
+
+template<long interpolation>
+void Comb::ProcessFeedBack(float *L, float *R, long n)
+{
+  const float dry = 0.99f-feedback;
+  // leaving room for the points of the interpolation, in case the delay
+  // was drawn at another sample rate
+  const float longest = float(dl.size()-4);
+  Tap tap = Tap();
+  float l = lastL, r = lastR;
+  long i = 0;
+  
+  // while the delay glides it is checked every sample, as in TickFeedBack(),
+  // so that the output doesn't depend on where the blocks are split
+  for(;i<n && std::fabs(lp.LastOut()-delay) >= kSettled;i++)
+  {
+    design<interpolation>(std::min(lp.LastOut(),longest),tap);
+    lp.tick(delay);
+    L[i] = clip(dry*L[i] + feedback*l);
+    R[i] = clip(dry*R[i] + feedback*r);
+    dl.write(L[i],R[i]);
+    read<interpolation>(dl,tap,l,r);
+  }
+  
+  // then held, one design for the rest of the block
+  if(i<n)
+  {
+    lp.SetState(delay);
+    design<interpolation>(std::min(delay,longest),tap);
+  }
+  for(;i<n;i++)
+  {
+    L[i] = clip(dry*L[i] + feedback*l);
+    R[i] = clip(dry*R[i] + feedback*r);
+    dl.write(L[i],R[i]);
+    read<interpolation>(dl,tap,l,r);
+  }
+  lastL = l;
+  lastR = r;
+}
+
+// one sample of ProcessFeedBack(), settling is checked every sample
+template<long interpolation>
+void Comb::TickFeedBack(float &out1, float &out2, const float in1, const float in2)
+{
+  const float dry = 0.99f-feedback;
+  const float longest = float(dl.size()-4);
+  // the state before the step, as in ProcessFeedBack()
+  float d = delay;
+  if(std::fabs(lp.LastOut()-delay) < kSettled)
+    lp.SetState(delay);
+  else
   {
-    dl1.set_delay(delay);
-    dl2.set_delay(delay);
+    d = lp.LastOut();
+    lp.tick(delay);
   }
+  
+  Tap tap = Tap();
+  design<interpolation>(std::min(d,longest),tap);
+  out1 = clip(dry*in1 + feedback*lastL);
+  out2 = clip(dry*in2 + feedback*lastR);
+  dl.write(out1,out2);
+  read<interpolation>(dl,tap,lastL,lastR);
 }
 
 void Comb::SetMinDelay(float v)
@@ -77,9 +330,52 @@ void Comb::SetSampleRate(float v)
 {
   sr = v;
   lp.SetSampleRate(v);
+  // the only allocation of the comb, switching it on just flips the flag
+  if(allocatedsr != sr)
+    AllocateDelays();
 }
 
 void Comb::SetOn(bool v)
 {
+  const bool wason = on;
   on = v;
+  if(on && !wason)
+    CatchUp();
+}
+
+/**
+  Draw again what the listener calls skipped while off, in the order they came.
+*/
+void Comb::CatchUp()
+{
+  const bool redoblock = missedblock || (missedcut && cuthasblock);
+  const long bar = lastbar, sd = lastsd;
+  if(missedcut)
+  {
+    if(cuthasblock)
+      OnBlock(cutbar,cutsd);
+    OnCut(lastcut,lastnumcuts);
+  }
+  if(redoblock)
+    OnBlock(bar,sd);
+  missedblock = missedcut = false;
+}
+
+void Comb::AllocateDelays()
+{
+  // OnCut sweeps from startdelay up to startdelay+enddelay, so twice the
+  // maximum, plus the points around it for the interpolation
+  dl.resize(long(2.f*kMaxDelay*sr/1000.f) + 4);
+  lastL = lastR = 0.f;
+  allocatedsr = sr;
+}
+
+void Comb::SetSeed(long v)
+{
+  seed = v;
+}
+
+void Comb::SetInterpolation(long v)
+{
+  interpolation = v;
 }
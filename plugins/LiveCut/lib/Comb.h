@@ -38,6 +38,14 @@ public:
     FeedBack
   };
   
+  // how the feedback path reads between samples
+  enum Interpolation
+  {
+    Linear=0,
+    Allpass,
+    Lagrange // third order
+  };
+  
 	Comb();
   
 	virtual void OnBlock(long bar, long sd);
@@ -49,43 +57,44 @@ public:
 	void SetFeedBack(float v);
 	void SetSampleRate(float v);
 	void SetOn(bool v);
+	void SetSeed(long v);
+	void SetInterpolation(long v);
+	inline bool IsOn() const {return on;}
+  
+  // LVC_MAXDELAY's upper limit, the delay lines are sized for it
+  static const float kMaxDelay; //ms
+  
+	// per sample, without the chunking of process()
+	void tick(float &out1,float &out2, const float in1, const float in2);
+  
+	// in place, whether on or not: the caller leaves the comb out of the chain while it's off
+	void process(float *L, float *R, long n);
   
-	inline void tick(float &out1,float &out2, const float in1, const float in2)
-	{
-		if(on)
-		{
-			if(type==FeedForward) // feedforward
-			{
-				out1 = 0.5f*(in1+dl1.tick(in1)); 
-				out2 = 0.5f*(in2+dl2.tick(in2));
-			} 
-			else // feedback
-			{
-				// need delay interpolation
-				dl1.set_delay(lp.LastOut());
-				dl2.set_delay(lp.LastOut());
-				lp.tick(delay);
-				out1 = clip((0.99f-feedback)*in1 + feedback*dl1.lastOut()); 
-				dl1.tick(out1);
-				out2 = clip((0.99f-feedback)*in2 + feedback*dl2.lastOut()); 
-				dl2.tick(out2);
-			}
-		} 
-		else
-		{
-			out1 = in1;
-			out2 = in2;
-		}
-	}
 private:
+	void AllocateDelays();
+	void ProcessFeedForward(float *L, float *R, long n);
+	template<long interpolation> void ProcessFeedBack(float *L, float *R, long n);
+	template<long interpolation> void TickFeedBack(float &out1, float &out2, const float in1, const float in2);
+  
 	float mindelay,maxdelay,startdelay,enddelay;//ms
-	DelayLine dl1,dl2;
+	StereoDelayLine dl;
+	float lastL,lastR; // last read of the delay line
 	float sr;
+	float allocatedsr; // the delay lines are sized for it
 	float feedback;
 	float delay;
 	FirstOrderLowpass lp;
 	bool on;
 	long type;
+	long interpolation;
+	Random rng;
+	long seed;
+	// the last block and cut, replayed when switched on if they were missed.
+	// The player announces the first cut of a block before the block itself,
+	// so the cut keeps the block it is computed with
+	void CatchUp();
+	bool hasblock,cuthasblock,missedblock,missedcut;
+	long lastbar,lastsd,lastcut,lastnumcuts,cutbar,cutsd;
 };
 
 #endif
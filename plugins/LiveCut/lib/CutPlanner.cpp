@@ -0,0 +1,178 @@
+/*
+ This file is part of Livecut
+ 
+ Livecut can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+ 
+ Livecut is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with Livecut; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330, 
+ Boston, MA 02111-1307 USA
+ */
+
+#include "CutPlanner.h"
+#include <chrono>
+
+PlannedCuts::PlannedCuts()
+: epoch(-1)
+, phrase(false)
+, phraseindex(0)
+, phrasebar(0)
+, barsnow(0)
+, unitsdone(0)
+, totalunits(0)
+, unitsinblock(0)
+, subdiv(0)
+, spu(0.0)
+{
+}
+
+//-------------------------------------------------------------------------------
+CutPlanner::CutPlanner(long capacity)
+: ring(std::max(capacity,1L))
+, head(0)
+, tail(0)
+, mailboxstate(kEmpty)
+, nextunit(0)
+, planning(false)
+, running(false)
+{
+}
+
+CutPlanner::~CutPlanner()
+{
+  Stop();
+}
+
+void CutPlanner::Start()
+{
+  Stop();
+  head = 0;
+  tail = 0;
+  mailboxstate = kEmpty;
+  planning = false;
+  running = true;
+  thread = std::thread(&CutPlanner::Run,this);
+}
+
+void CutPlanner::Stop()
+{
+  running = false;
+  if(thread.joinable())
+    thread.join();
+}
+
+PlannedCuts *CutPlanner::Front(long epoch)
+{
+  long h = head.load(std::memory_order_relaxed);
+  while(h != tail.load(std::memory_order_acquire))
+  {
+    PlannedCuts &p = ring[h % long(ring.size())];
+    if(p.epoch == epoch)
+      return &p;
+    // planned from an older state
+    head.store(++h,std::memory_order_release);
+  }
+  return NULL;
+}
+
+void CutPlanner::Pop()
+{
+  head.store(head.load(std::memory_order_relaxed)+1,std::memory_order_release);
+}
+
+bool CutPlanner::Publish(long epoch, const CutState &state,
+                         long phraseindex, long phrasebar,
+                         long unitsdone, long totalunits, long unitsinblock,
+                         long subdiv, double spu)
+{
+  // take the mailbox back unless the worker is reading it
+  int s = mailboxstate.load(std::memory_order_acquire);
+  if(s == kFull && !mailboxstate.compare_exchange_strong(s,int(kEmpty),std::memory_order_acquire))
+    return false;
+  if(s == kReading)
+    return false;
+  
+  mailbox.epoch = epoch;
+  mailbox.state = state;
+  mailbox.phraseindex = phraseindex;
+  mailbox.phrasebar = phrasebar;
+  mailbox.unitsdone = unitsdone;
+  mailbox.totalunits = totalunits;
+  mailbox.unitsinblock = unitsinblock;
+  mailbox.subdiv = subdiv;
+  mailbox.spu = spu;
+  mailboxstate.store(kFull,std::memory_order_release);
+  return true;
+}
+
+bool CutPlanner::TakeSnapshot()
+{
+  int s = kFull;
+  if(!mailboxstate.compare_exchange_strong(s,int(kReading),std::memory_order_acquire))
+    return false;
+  current = mailbox;
+  mailboxstate.store(kEmpty,std::memory_order_release);
+  
+  // the published block has been decided, plan from the one after
+  nextunit = current.unitsdone + std::max(current.unitsinblock,1L);
+  return true;
+}
+
+void CutPlanner::PlanNext()
+{
+  const long t = tail.load(std::memory_order_relaxed);
+  PlannedCuts &p = ring[t % long(ring.size())];
+  
+  p.epoch = current.epoch;
+  p.subdiv = current.subdiv;
+  p.spu = current.spu;
+  
+  // same sequence as BBCutter::SetPosition with a running transport
+  if(nextunit>=current.totalunits)
+  {
+    p.phrase = true;
+    current.state.LocatePhrase(current.phrasebar + current.totalunits/current.subdiv,
+                               current.phraseindex,current.phrasebar,p.barsnow);
+    current.totalunits = p.barsnow*current.subdiv;
+    current.unitsinblock = 0;
+    nextunit = 0;
+  }
+  else
+  {
+    p.phrase = false;
+    p.cuts.clear();
+    current.state.ChooseCuts(p.cuts,current.unitsinblock,current.phraseindex,
+                             nextunit,current.totalunits,current.subdiv,current.spu);
+    p.unitsdone = nextunit;
+    p.unitsinblock = current.unitsinblock;
+    nextunit += std::max(current.unitsinblock,1L);
+  }
+  p.phraseindex = current.phraseindex;
+  p.phrasebar = current.phrasebar;
+  p.totalunits = current.totalunits;
+  p.after = current.state;
+  
+  tail.store(t+1,std::memory_order_release);
+}
+
+void CutPlanner::Run()
+{
+  while(running.load(std::memory_order_acquire))
+  {
+    if(TakeSnapshot())
+      planning = true;
+    
+    const long queued = tail.load(std::memory_order_relaxed) - head.load(std::memory_order_acquire);
+    if(planning && queued < long(ring.size()))
+      PlanNext();
+    else
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
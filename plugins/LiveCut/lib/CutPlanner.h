@@ -0,0 +1,111 @@
+/*
+ This file is part of Livecut
+ 
+ Livecut can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+ 
+ Livecut is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with Livecut; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330, 
+ Boston, MA 02111-1307 USA
+ */
+
+#ifndef LIVECUT_CUT_PLANNER_H
+#define LIVECUT_CUT_PLANNER_H
+
+#include "BBCutter.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+/**
+ @brief one decision of the cutter, taken ahead of time
+ 
+ either the length of a new phrase or the cuts of a block, along with the
+ position it was taken for and the state of the procs right after it.
+ */
+struct PlannedCuts
+{
+  PlannedCuts();
+  
+  long epoch;
+  bool phrase;
+  long phraseindex, phrasebar, barsnow;
+  long unitsdone, totalunits, unitsinblock, subdiv;
+  double spu;
+  CutList cuts;
+  CutState after;
+};
+
+/**
+ @brief takes the cut decisions of a BBCutter on a worker thread
+ 
+ the cutter publishes its state after each block it had to decide itself,
+ the worker then plays the phrase/block sequence forward from there,
+ assuming the transport keeps running, and queues the decisions in a
+ single producer/single consumer ring.
+ the cutter pops them as long as they match its position and epoch, and
+ falls back to deciding synchronously otherwise. as a decision carries the
+ state that follows it the output is the same either way.
+ 
+ nothing on the audio thread side blocks or allocates.
+ */
+class CutPlanner
+{
+public:
+  CutPlanner(long capacity=8);
+  ~CutPlanner();
+  
+  // start and stop the worker, not from the audio thread
+  void Start();
+  void Stop();
+  bool IsRunning() const { return thread.joinable(); }
+  
+  // audio thread: oldest planned decision of this epoch, NULL if there is none yet
+  PlannedCuts *Front(long epoch);
+  void Pop();
+  // audio thread: restart planning from this state, false if the worker is busy reading
+  // the previous one, try again later
+  bool Publish(long epoch, const CutState &state,
+               long phraseindex, long phrasebar,
+               long unitsdone, long totalunits, long unitsinblock,
+               long subdiv, double spu);
+  
+private:
+  void Run();
+  bool TakeSnapshot();
+  void PlanNext();
+  
+  struct Snapshot
+  {
+    long epoch;
+    CutState state;
+    long phraseindex, phrasebar;
+    long unitsdone, totalunits, unitsinblock, subdiv;
+    double spu;
+  };
+  
+  enum { kEmpty=0, kFull, kReading };
+  
+private:
+  std::vector<PlannedCuts> ring;
+  std::atomic<long> head, tail;
+  Snapshot mailbox;
+  std::atomic<int> mailboxstate;
+  
+  // worker only
+  Snapshot current;
+  long nextunit;
+  bool planning;
+  
+  std::atomic<bool> running;
+  std::thread thread;
+};
+
+#endif
@@ -18,21 +18,56 @@
  */
 
 #include "DelayLine.h"
+#include <algorithm>
 #include <cstring>
 
-DelayLine::DelayLine(float delay, long size)
+// dest[i] = (1-frac)*src[i] + frac*src[i+1]
+static inline void interpolate(float dest[], const float *src, float frac, int n)
+{
+  int i=0;
+#if defined(__SSE2__)
+  const __m128 f = _mm_set1_ps(frac);
+  const __m128 g = _mm_set1_ps(1.0f-frac);
+  for(;i+4<=n;i+=4)
+    _mm_storeu_ps(dest+i, _mm_add_ps(_mm_mul_ps(g,_mm_loadu_ps(src+i)), _mm_mul_ps(f,_mm_loadu_ps(src+i+1))));
+#endif
+  for(;i<n;i++)
+    dest[i] = (1.0f-frac)*src[i] + frac*src[i+1];
+}
+
+// same for interleaved frames, de-interleaved into L and R
+static inline void interpolate(float L[], float R[], const float *src, float frac, int n)
+{
+  int i=0;
+#if defined(__SSE2__)
+  const __m128 f = _mm_set1_ps(frac);
+  const __m128 g = _mm_set1_ps(1.0f-frac);
+  for(;i+4<=n;i+=4)
+  {
+    const float *s = src+2*i;
+    const __m128 y0 = _mm_add_ps(_mm_mul_ps(g,_mm_loadu_ps(s)),   _mm_mul_ps(f,_mm_loadu_ps(s+2)));
+    const __m128 y1 = _mm_add_ps(_mm_mul_ps(g,_mm_loadu_ps(s+4)), _mm_mul_ps(f,_mm_loadu_ps(s+6)));
+    _mm_storeu_ps(L+i, _mm_shuffle_ps(y0,y1,_MM_SHUFFLE(2,0,2,0)));
+    _mm_storeu_ps(R+i, _mm_shuffle_ps(y0,y1,_MM_SHUFFLE(3,1,3,1)));
+  }
+#endif
+  for(;i<n;i++)
+  {
+    L[i] = (1.0f-frac)*src[2*i]   + frac*src[2*i+2];
+    R[i] = (1.0f-frac)*src[2*i+1] + frac*src[2*i+3];
+  }
+}
+
+DelayLine::DelayLine(float delay, long size, long sizing)
 : mpBuffer(0)
 , mLastOut(0)
 , mDelay(delay)
 , mWriteIndex(0)
-, mMask(0)
 , mSize(0)
+, mSizing(sizing)
 {
-  int n = int(floor (log(double(size))/log(2.0) + 0.5))+1;
-  mMask = 1 ; mMask <<= n; mMask -= 1;
-  mSize = mMask+1;
-  mpBuffer = new float[mSize];
-  clear();
+  if(size>0)
+    resize(size);
 }
 
 DelayLine::~DelayLine()
@@ -42,30 +77,121 @@ DelayLine::~DelayLine()
   mpBuffer = 0;
 }
 
+long DelayLine::rounded_size(long size, long sizing)
+{
+  long rounded = 1;
+  if(sizing == Exact)
+  {
+    rounded = std::max(size, 2L);
+  }
+  else if(sizing == NextPowerOf2)
+  {
+    while(rounded < size)
+      rounded <<= 1;
+    rounded = std::max(rounded, 2L);
+  }
+  else
+  {
+    int n = int(floor (log(double(size))/log(2.0) + 0.5))+1;
+    // when N is a multiple of 2 we choose the next power of 2...
+    // not good... cf OLA ou FFTFactory
+    rounded <<= n;
+  }
+  return rounded;
+}
+
 void DelayLine::resize(int size)
 {
-  int n = int(floor (log(double(size))/log(2.0) + 0.5))+1;
-  // when N is a multiple of 2 we choose the next power of 2...
-  // not good... cf OLA ou FFTFactory
-  mMask = 1 ; mMask <<= n; mMask -= 1;
-  mSize = mMask+1;
+  mSize = rounded_size(size, mSizing);
   if(0 != mpBuffer)
     delete[] mpBuffer;
   mpBuffer = 0;
-  mpBuffer = new float[mSize];
+  mpBuffer = new float[mSize+kMirror];
   mWriteIndex = 0;
+  set_delay(mDelay);
   clear();
 }
 
 
 void DelayLine::set_delay(float delay)
 {
-  mDelay = delay;
+  mDelay = (mSize > 0) ? std::min(delay, float(mSize-1)) : delay;
+}
+
+long DelayLine::wrap(long i) const
+{
+  i %= mSize;
+  return (i < 0) ? i+mSize : i;
+}
+
+void DelayLine::mirror()
+{
+  for(long i=0;i<kMirror;i++)
+    mpBuffer[mSize+i] = mpBuffer[i];
+}
+
+void DelayLine::tick(const float x[], float y[], int size)
+{
+  // each chunk is written, then read back as one span, as long as its
+  // reads neither reach into it nor into what it overwrites
+  const long chunk = mSize - (long(mDelay)+2);
+  if(mDelay < 1.0f || chunk <= 0)
+  {
+    for(int i=0;i<size;i++)
+      y[i] = tick(x[i]);
+    return;
+  }
+  
+  while(size>0)
+  {
+    const int n = std::min<long>(size, chunk);
+    write(x,n);
+    span(y,n,mDelay,n);
+    mLastOut = y[n-1];
+    x += n;
+    y += n;
+    size -= n;
+  }
+}
+
+void DelayLine::write(const float x[], int size)
+{
+  while(size>0)
+  {
+    const int n = std::min<long>(size, mSize-mWriteIndex);
+    std::memcpy(mpBuffer+mWriteIndex,x,n*sizeof(float));
+    x += n;
+    size -= n;
+    mWriteIndex = index(mWriteIndex+n);
+  }
+  mirror();
+}
+
+void DelayLine::tapL(float dest[], float samples, int size)
+{
+  span(dest,0,samples,size);
+}
+
+void DelayLine::span(float dest[], long back, float delay, int size)
+{
+  // same rounding as linear_interpolation(), with one fraction for the span
+  const long k = lrintf(-delay);
+  const float frac = -delay - float(k);
+  long p = wrap(mWriteIndex-back+k);
+  int i=0;
+  while(i<size)
+  {
+    // up to the end of the buffer, the mirror holds the second point of the last sample
+    const int n = std::min<long>(size-i, mSize-p);
+    interpolate(dest+i,mpBuffer+p,frac,n);
+    i += n;
+    p = index(p+n);
+  }
 }
 
 void DelayLine::replace(const float x[],int pos,int size)
 {
-  int p = (mWriteIndex+pos); p &= mMask;
+  int p = wrap(mWriteIndex+pos);
   int n = mSize-p;
   if(n>size)
     n = size ;
@@ -83,11 +209,12 @@ void DelayLine::replace(const float x[],int pos,int size)
   {
     dest[i-n] = x[i];
   }
+  mirror();
 }
 
 void DelayLine::write(const float x[],int pos,int size)
 {
-  int p = (mWriteIndex+pos); p &= mMask;
+  int p = wrap(mWriteIndex+pos);
   int n = mSize-p;
   if(n>size)
     n = size ;
@@ -105,13 +232,13 @@ void DelayLine::write(const float x[],int pos,int size)
   {
     dest[i-n] += x[i];
   }
+  mirror();
 }
 
 
 void DelayLine::read(float dest[],int pos,int size)
 {
-  int p = (mWriteIndex+(pos+mSize));
-  p    &= mMask;
+  int p = wrap(mWriteIndex+pos);
   int n = mSize-p;
   
   if(size<n)
@@ -121,16 +248,183 @@ void DelayLine::read(float dest[],int pos,int size)
   else
   {
     std::memcpy(dest,mpBuffer+p,n*sizeof(float));
-    std::memcpy(dest,mpBuffer,(size-n)*sizeof(float));
+    std::memcpy(dest+n,mpBuffer,(size-n)*sizeof(float));
   }
 }
 
 void DelayLine::clear()
 {
-  for(int i=0;i<mSize;i++)
+  for(int i=0;i<mSize+kMirror;i++)
   {
     mpBuffer[i] = 0.0f;
   }
   mLastOut=0.0f;
 }
 
+//-------------------------------------------------------
+StereoDelayLine::StereoDelayLine(float delay, long size, long sizing)
+: mpBuffer(0)
+, mLastOutL(0)
+, mLastOutR(0)
+, mDelay(delay)
+, mWriteIndex(0)
+, mSize(0)
+, mSizing(sizing)
+{
+  if(size>0)
+    resize(size);
+}
+
+StereoDelayLine::~StereoDelayLine()
+{
+  if(0 != mpBuffer)
+    delete[] mpBuffer;
+  mpBuffer = 0;
+}
+
+void StereoDelayLine::resize(int size)
+{
+  mSize = DelayLine::rounded_size(size, mSizing);
+  if(0 != mpBuffer)
+    delete[] mpBuffer;
+  mpBuffer = 0;
+  mpBuffer = new float[2*(mSize+DelayLine::kMirror)];
+  mWriteIndex = 0;
+  set_delay(mDelay);
+  clear();
+}
+
+void StereoDelayLine::set_delay(float delay)
+{
+  mDelay = (mSize > 0) ? std::min(delay, float(mSize-1)) : delay;
+}
+
+long StereoDelayLine::wrap(long i) const
+{
+  i %= mSize;
+  return (i < 0) ? i+mSize : i;
+}
+
+void StereoDelayLine::mirror()
+{
+  for(long i=0;i<2*DelayLine::kMirror;i++)
+    mpBuffer[2*mSize+i] = mpBuffer[i];
+}
+
+void StereoDelayLine::tick(const float inL[], const float inR[], float outL[], float outR[], int size)
+{
+  // see DelayLine::tick()
+  const long chunk = mSize - (long(mDelay)+2);
+  if(mDelay < 1.0f || chunk <= 0)
+  {
+    for(int i=0;i<size;i++)
+      tick(outL[i],outR[i],inL[i],inR[i]);
+    return;
+  }
+  
+  while(size>0)
+  {
+    const int n = std::min<long>(size, chunk);
+    write(inL,inR,n);
+    span(outL,outR,n,mDelay,n);
+    mLastOutL = outL[n-1];
+    mLastOutR = outR[n-1];
+    inL += n;
+    inR += n;
+    outL += n;
+    outR += n;
+    size -= n;
+  }
+}
+
+void StereoDelayLine::tapL(float L[], float R[], float samples, int size)
+{
+  span(L,R,0,samples,size);
+}
+
+void StereoDelayLine::span(float L[], float R[], long back, float delay, int size)
+{
+  const long k = lrintf(-delay);
+  const float frac = -delay - float(k);
+  long p = wrap(mWriteIndex-back+k);
+  int i=0;
+  while(i<size)
+  {
+    const int n = std::min<long>(size-i, mSize-p);
+    interpolate(L+i,R+i,mpBuffer+2*p,frac,n);
+    i += n;
+    p += n;
+    if(p == mSize) p = 0;
+  }
+}
+
+void StereoDelayLine::write(const float L[], const float R[], int size)
+{
+  while(size>0)
+  {
+    // up to the end of the buffer
+    const int n = std::min<long>(size, mSize-mWriteIndex);
+    float *dest = mpBuffer + 2*mWriteIndex;
+    int i=0;
+#if defined(__SSE2__)
+    for(;i+4<=n;i+=4)
+    {
+      const __m128 l = _mm_loadu_ps(L+i);
+      const __m128 r = _mm_loadu_ps(R+i);
+      _mm_storeu_ps(dest+2*i,   _mm_unpacklo_ps(l,r));
+      _mm_storeu_ps(dest+2*i+4, _mm_unpackhi_ps(l,r));
+    }
+#endif
+    for(;i<n;i++)
+    {
+      dest[2*i]   = L[i];
+      dest[2*i+1] = R[i];
+    }
+    L += n;
+    R += n;
+    size -= n;
+    mWriteIndex += n;
+    if(mWriteIndex == mSize) mWriteIndex = 0;
+  }
+  mirror();
+}
+
+void StereoDelayLine::read(float L[], float R[], int pos, int size)
+{
+  long p = wrap(mWriteIndex+pos);
+  while(size>0)
+  {
+    const int n = std::min<long>(size, mSize-p);
+    const float *src = mpBuffer + 2*p;
+    int i=0;
+#if defined(__SSE2__)
+    for(;i+4<=n;i+=4)
+    {
+      const __m128 a = _mm_loadu_ps(src+2*i);
+      const __m128 b = _mm_loadu_ps(src+2*i+4);
+      _mm_storeu_ps(L+i, _mm_shuffle_ps(a,b,_MM_SHUFFLE(2,0,2,0)));
+      _mm_storeu_ps(R+i, _mm_shuffle_ps(a,b,_MM_SHUFFLE(3,1,3,1)));
+    }
+#endif
+    for(;i<n;i++)
+    {
+      L[i] = src[2*i];
+      R[i] = src[2*i+1];
+    }
+    L += n;
+    R += n;
+    size -= n;
+    p += n;
+    if(p == mSize) p = 0;
+  }
+}
+
+void StereoDelayLine::clear()
+{
+  for(long i=0;i<2*(mSize+DelayLine::kMirror);i++)
+  {
+    mpBuffer[i] = 0.0f;
+  }
+  mLastOutL = mLastOutR = 0.0f;
+}
+
@@ -21,33 +21,85 @@
 #define _mDelay_line__
 
 #include <math.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 //-------------------------------------------------------
-inline float linear_interpolation(const float* data, unsigned long mask, float pos)
+// lrintf() inlined, which compilers won't do while it may set errno
+inline int round_to_int(float x)
 {
-	int ipos = lrintf(pos);
+#if defined(__SSE2__)
+	return _mm_cvtss_si32(_mm_set_ss(x));
+#else
+	return int(lrintf(x));
+#endif
+}
+
+// data holds size samples followed by a copy of the first ones,
+// so that any pos in [0,2*size) is read with a single wrap
+inline float linear_interpolation(const float* data, long size, float pos)
+{
+	int ipos = round_to_int(pos);
+	float frac = float(pos-ipos);
+	if(ipos >= size) ipos -= size;
+  return (1.0f-frac)*data[ipos] + frac*data[ipos+1];
+}
+
+// same for interleaved stereo frames, both channels at once
+inline void linear_interpolation(const float* data, long size, float pos, float &L, float &R)
+{
+	int ipos = round_to_int(pos);
 	float frac = float(pos-ipos);
-  return (1.0f-frac)*data[ipos&mask] + frac*data[(ipos+1)&mask];
+	if(ipos >= size) ipos -= size;
+	const float *a = data + 2*ipos;
+	const float *b = a + 2;
+#if defined(__SSE2__)
+	const __m128 y = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(1.0f-frac), _mm_loadl_pi(_mm_setzero_ps(), (const __m64*)a)),
+	                            _mm_mul_ps(_mm_set1_ps(frac), _mm_loadl_pi(_mm_setzero_ps(), (const __m64*)b)));
+	L = _mm_cvtss_f32(y);
+	R = _mm_cvtss_f32(_mm_shuffle_ps(y, y, _MM_SHUFFLE(1,1,1,1)));
+#else
+	L = (1.0f-frac)*a[0] + frac*b[0];
+	R = (1.0f-frac)*a[1] + frac*b[1];
+#endif
 }
 
 //-------------------------------------------------------
+// The indices wrap with a compare rather than a mask, and the first samples
+// are mirrored after the end for the interpolation, so any size will do.
 class DelayLine
 {
 public:
-  DelayLine(float delay=22050, long size=44100);
+  // how resize() sizes the line
+  enum Sizing
+  {
+    PowerOf2=0, // rounded like it always was, often to twice the size or more
+    Exact,
+    NextPowerOf2 // the smallest power of 2 it fits in
+  };
+  
+  // the number of samples resize(size) allocates, before the mirror
+  static long rounded_size(long size, long sizing);
+  
+  // size<=0 leaves the line unallocated until resize()
+  DelayLine(float delay=22050, long size=44100, long sizing=PowerOf2);
   ~DelayLine();
   
 	void resize(int size);
   
+  // at most the size of the line less one
   void set_delay(float delay);
   
   inline float tick(const float x)
 	{
-		mpBuffer[mWriteIndex] = x; 
 		const float pos = float(mWriteIndex+mSize)-mDelay;
-		(++mWriteIndex) &= mMask;
-		return (mLastOut = linear_interpolation(mpBuffer,mMask,pos));
+		write(x);
+		return (mLastOut = linear_interpolation(mpBuffer,mSize,pos));
 	}
+  
+  // block tick() holding the delay, y may be x
+  void tick(const float x[], float y[], int size);
 	
   void replace(const float x[],int pos,int size);
 	void write(const float x[],int pos,int size);
@@ -55,32 +107,42 @@ public:
   inline void write(const float x)
 	{
 		mpBuffer[mWriteIndex] = x;
-		mWriteIndex++; mWriteIndex &= mMask;
+		if(mWriteIndex < kMirror)
+			mpBuffer[mSize+mWriteIndex] = x;
+		if(++mWriteIndex == mSize) mWriteIndex = 0;
   }
   
+  // block write(x), appends size samples
+  void write(const float x[], int size);
+  
   inline float read()
 	{
 		float tmp = mpBuffer[mWriteIndex];
-		mWriteIndex++;mWriteIndex &= mMask;
+		if(++mWriteIndex == mSize) mWriteIndex = 0;
 		return tmp;
 	}
   
   inline float tap(const long samples)
 	{
-		return mpBuffer[(mWriteIndex+mSize-samples)&mMask];
+		return mpBuffer[index(mWriteIndex+mSize-samples)];
 	}
   
   inline float tapL(const float samples)
 	{
 		const float pos = float(mWriteIndex+mSize)-samples;
-		return linear_interpolation(mpBuffer,mMask,pos);
+		return linear_interpolation(mpBuffer,mSize,pos);
 	}
   
+  // the span starting samples behind the write index, dest[i] = tapL(samples-i)
+  void tapL(float dest[], float samples, int size);
+  
   inline float readErase()
 	{
 		float tmp = mpBuffer[mWriteIndex];
 		mpBuffer[mWriteIndex] = 0.0f; //erase automatically after read
-		mWriteIndex++; mWriteIndex &= mMask;
+		if(mWriteIndex < kMirror)
+			mpBuffer[mSize+mWriteIndex] = 0.0f;
+		if(++mWriteIndex == mSize) mWriteIndex = 0;
 		return tmp;
 	}
   
@@ -88,17 +150,115 @@ public:
   
   void clear();
   
-  float* get_ptr(int pos=0)	{return &(mpBuffer[(mWriteIndex+pos)&mMask]);}
+  float* get_ptr(int pos=0)	{return &(mpBuffer[wrap(mWriteIndex+pos)]);}
   
   inline float lastOut()  {return mLastOut;}
   
+  inline bool allocated() const {return 0 != mpBuffer;}
+  
+  inline long size() const {return mSize;}
+  
+  // samples copied after the end of the buffer, so that up to kMirror+1
+  // consecutive samples can be read from anywhere without wrapping
+  static const long kMirror = 4;
+  
 private:
+  // i in [0,2*size)
+  inline long index(long i) const {return (i >= mSize) ? i-mSize : i;}
+  // any i
+  long wrap(long i) const;
+  void mirror();
+  
+  // the span starting delay samples before the sample written back samples ago
+  void span(float dest[], long back, float delay, int size);
+  
   float* mpBuffer;
   float mLastOut;
   float mDelay;
   long mWriteIndex;
-  long mMask;
   long mSize;
+  long mSizing;
+};
+
+//-------------------------------------------------------
+// Two delay lines always read and written at the same place, e.g. the left
+// and right channels of an effect, kept in one buffer with L and R side by
+// side so that a frame is a single memory access.
+class StereoDelayLine
+{
+public:
+  // size<=0 leaves the line unallocated until resize()
+  StereoDelayLine(float delay=22050, long size=44100, long sizing=DelayLine::PowerOf2);
+  ~StereoDelayLine();
+  
+  // size in frames, rounded like a DelayLine of the same sizing
+	void resize(int size);
+  
+  // at most the size of the line less one
+  void set_delay(float delay);
+  
+  inline void tick(float &outL, float &outR, const float inL, const float inR)
+	{
+		const float pos = float(mWriteIndex+mSize)-mDelay;
+		write(inL,inR);
+		linear_interpolation(mpBuffer,mSize,pos,mLastOutL,mLastOutR);
+		outL = mLastOutL;
+		outR = mLastOutR;
+	}
+  
+  // block tick() holding the delay, the outputs may be the inputs
+  void tick(const float inL[], const float inR[], float outL[], float outR[], int size);
+  
+  inline void write(const float inL, const float inR)
+	{
+		float *frame = mpBuffer + 2*mWriteIndex;
+		frame[0] = inL;
+		frame[1] = inR;
+		if(mWriteIndex < DelayLine::kMirror)
+		{
+			frame[2*mSize]   = inL;
+			frame[2*mSize+1] = inR;
+		}
+		if(++mWriteIndex == mSize) mWriteIndex = 0;
+	}
+  
+  // block versions: write() appends size frames, read() copies size frames
+  // from pos frames after the write index, like DelayLine::read()
+  void write(const float L[], const float R[], int size);
+  void read(float L[], float R[], int pos, int size);
+  
+  // the frame written samples ago, tap(1) is the last one.
+  // The DelayLine::kMirror frames after it follow it in memory.
+  inline const float* tap(const long samples) const
+	{
+		const long i = mWriteIndex+mSize-samples;
+		return mpBuffer + 2*((i >= mSize) ? i-mSize : i);
+	}
+  
+  // like DelayLine::tapL() over a span
+  void tapL(float L[], float R[], float samples, int size);
+  
+  void clear();
+  
+  inline float lastOutL() {return mLastOutL;}
+  inline float lastOutR() {return mLastOutR;}
+  
+  inline bool allocated() const {return 0 != mpBuffer;}
+  
+  inline long size() const {return mSize;}
+  
+private:
+  long wrap(long i) const;
+  void mirror();
+  void span(float L[], float R[], long back, float delay, int size);
+  
+  float* mpBuffer;
+  float mLastOutL;
+  float mLastOutR;
+  float mDelay;
+  long mWriteIndex;
+  long mSize; // frames
+  long mSizing;
 };
 
 #endif //_mDelay_line_
@@ -25,6 +25,7 @@ FirstOrderLowpass::FirstOrderLowpass()
 : lambda(0)
 , sr(0)
 , lastout(0)
+, rand_state(0)
 {
 }
 
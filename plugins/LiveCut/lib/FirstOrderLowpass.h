@@ -20,6 +20,8 @@
 #ifndef FIRST_ORDER_LOWPASS_H
 #define FIRST_ORDER_LOWPASS_H
 
+#include <cstring>
+
 class FirstOrderLowpass
 {
 public:
@@ -46,10 +48,12 @@ public:
 	
   inline void add_white_noise (float &val)
 	{
-    static unsigned int rand_state = rand_state * 1234567UL + 890123UL;
+    rand_state = rand_state * 1234567UL + 890123UL;
     int mantissa = rand_state & 0x807F0000; // Keep only most significant bits
     int flt_rnd = mantissa | 0x1E000000; // Set exponent
-    val += *reinterpret_cast <const float *> (&flt_rnd);
+    float noise;
+    std::memcpy(&noise, &flt_rnd, sizeof(noise));
+    val += noise;
 	}
 	
   void SetState(float v);
@@ -59,6 +63,7 @@ protected:
 	float sr;
 	float lastout;
 	float time;  
+	unsigned int rand_state; // per filter, nothing shared between instances or threads
 };
 
 #endif
@@ -0,0 +1,115 @@
+/*
+ This file is part of Livecut
+ Copyright 2004 by Remy Muller.
+ Adapted for DISTRHO Plugin Framework (DPF) by eventual-recluse.
+
+ Livecut can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+
+ Livecut is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Livecut; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA 02111-1307 USA
+ */
+
+/* test-bitcrusher: BitCrusher::process() in blocks of any length against tick() */
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+#include "BitCrusher.h"
+
+static int failures = 0;
+
+static void fill(Random& rng, std::vector<float>& x, long n)
+{
+    x.resize(n);
+    for (long i = 0; i < n; i++)
+        x[i] = (float)rng.randomfloat(-1.0, 1.0);
+}
+
+/**
+  Cuts of random lengths, each one split in blocks of the given length (0 for
+  random ones) for process(), and run sample by sample through tick().
+  Both quantize the same way, so the outputs must be the same.
+ */
+static void test_crusher(float minfreq, float maxfreq, long block)
+{
+    BitCrusher a, b;
+    BitCrusher* crushers[] = { &a, &b };
+    for (int c = 0; c < 2; c++)
+    {
+        crushers[c]->SetSampleRate(44100.f);
+        crushers[c]->SetMinBits(1.f);
+        crushers[c]->SetMaxBits(16.f);
+        crushers[c]->SetMinFreq(minfreq);
+        crushers[c]->SetMaxFreq(maxfreq);
+        crushers[c]->SetSeed(5);
+    }
+
+    Random rng(11, 3);
+    std::vector<float> L, R, outL, outR;
+    for (long cut = 0; cut < 300; cut++)
+    {
+        // a block of 4 cuts, as the player announces them
+        if (cut % 4 == 0)
+        {
+            a.OnBlock(cut / 16, (cut / 4) % 4);
+            b.OnBlock(cut / 16, (cut / 4) % 4);
+        }
+        a.OnCut(cut % 4, 4);
+        b.OnCut(cut % 4, 4);
+
+        const long n = rng.randominteger(1, 6000);
+        fill(rng, L, n);
+        fill(rng, R, n);
+        outL.resize(n);
+        outR.resize(n);
+        for (long i = 0; i < n; i++)
+            b.tick(outL[i], outR[i], L[i], R[i]);
+
+        for (long i = 0; i < n;)
+        {
+            const long length = std::min(block ? block : rng.randominteger(1, 100), n - i);
+            a.process(&L[i], &R[i], length);
+            i += length;
+        }
+
+        for (long i = 0; i < n; i++)
+        {
+            if (L[i] == outL[i] && R[i] == outR[i])
+                continue;
+            if (failures < 20)
+                std::fprintf(stderr, "%g-%g Hz, blocks of %ld: cut %ld wrong at %ld\n",
+                             minfreq, maxfreq, block, cut, i);
+            ++failures;
+            break;
+        }
+    }
+}
+
+int main()
+{
+    // hold points far apart, a few samples apart, and on every sample
+    static const float freqs[][2] = { { 100.f, 1000.f }, { 2000.f, 20000.f }, { 20000.f, 44100.f } };
+    static const long blocks[] = { 1, 3, 8, 9, 64, 1000, 100000, 0 };
+
+    for (unsigned f = 0; f < sizeof(freqs)/sizeof(freqs[0]); f++)
+        for (unsigned b = 0; b < sizeof(blocks)/sizeof(blocks[0]); b++)
+            test_crusher(freqs[f][0], freqs[f][1], blocks[b]);
+
+    if (failures)
+    {
+        std::fprintf(stderr, "test-bitcrusher: %d failure(s)\n", failures);
+        return 1;
+    }
+    std::printf("test-bitcrusher: ok\n");
+    return 0;
+}
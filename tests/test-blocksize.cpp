@@ -0,0 +1,122 @@
+/*
+ This file is part of Livecut
+ Copyright 2004 by Remy Muller.
+ Adapted for DISTRHO Plugin Framework (DPF) by eventual-recluse.
+
+ Livecut can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+
+ Livecut is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Livecut; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA 02111-1307 USA
+ */
+
+
+/* test-blocksize: the same input rendered at any block size gives the same output */
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "LiveCutControls.hpp"
+#include "LiveCutEngine.hpp"
+#include "BBCutter.h"
+
+static const double kSampleRate = 44100.0;
+static const double kTempo = 133.0;
+static const long kFrames = 8 * 44100;
+
+struct Setting
+{
+    const char* name;
+    float parameters[8][2]; // index, value, index < 0 ends the list
+};
+
+static const Setting settings[] =
+{
+    { "plain", { { -1, 0 } } },
+    { "warp pitch", { { LVC_CUTPROC, 1 }, { LVC_MINPITCH, -700 }, { LVC_MAXPITCH, 700 }, { LVC_FADE, 30 }, { -1, 0 } } },
+    { "sqpusher crusher", { { LVC_CUTPROC, 2 }, { LVC_SUBDIV, 4 }, { LVC_CRUSHER, 1 }, { LVC_MINBITS, 4 },
+                              { LVC_MINFREQ, 2000 }, { LVC_MAXFREQ, 20000 }, { -1, 0 } } },
+    { "crusher low rate", { { LVC_CRUSHER, 1 }, { LVC_MINFREQ, 441 }, { LVC_MAXFREQ, 1000 }, { -1, 0 } } },
+    { "comb feedback", { { LVC_COMB, 1 }, { LVC_TYPE, 1 }, { LVC_FEEDBACK, 0.7f }, { LVC_MINDELAY, 2 }, { LVC_MAXDELAY, 30 }, { -1, 0 } } },
+};
+
+/**
+  Render the same noise with a host playing from the song start at a constant tempo,
+  in blocks of blockSize frames.
+ */
+static void render(const Setting& setting, uint32_t blockSize, bool planner, std::vector<float>& outL, std::vector<float>& outR)
+{
+    Random rng;
+    rng.seed(1, 7);
+    outL.resize(kFrames);
+    outR.resize(kFrames);
+    for (long i = 0; i < kFrames; i++)
+    {
+        outL[i] = (float)rng.randomfloat(-1.0, 1.0);
+        outR[i] = (float)rng.randomfloat(-1.0, 1.0);
+    }
+
+    LiveCutEngine engine;
+    engine.set_sample_rate(kSampleRate);
+    engine.set_planner_enabled(planner);
+    for (int i = 0; setting.parameters[i][0] >= 0; i++)
+        engine.set_parameter((uint32_t)setting.parameters[i][0], setting.parameters[i][1]);
+    engine.activate();
+
+    for (uint64_t frame = 0; frame < (uint64_t)kFrames; )
+    {
+        const uint32_t n = (uint32_t)std::min<uint64_t>(blockSize, kFrames - frame);
+        const LiveCutTransport transport = { kTempo, 4.0, 4.0, frame / kSampleRate * kTempo / 60.0, frame };
+        engine.run(&outL[frame], &outR[frame], &outL[frame], &outR[frame], n, transport);
+        frame += n;
+    }
+    engine.deactivate();
+}
+
+int main()
+{
+    static const uint32_t blockSizes[] = { 1, 64, 512, 4096 };
+
+    int failures = 0;
+    for (unsigned s = 0; s < sizeof(settings)/sizeof(settings[0]); s++)
+    {
+        std::vector<float> refL, refR, outL, outR;
+        render(settings[s], blockSizes[0], false, refL, refR);
+
+        // and the planner at a block size that isn't a power of 2
+        for (unsigned b = 1; b <= sizeof(blockSizes)/sizeof(blockSizes[0]); b++)
+        {
+            const bool planner = b == sizeof(blockSizes)/sizeof(blockSizes[0]);
+            const uint32_t blockSize = planner ? 333 : blockSizes[b];
+            render(settings[s], blockSize, planner, outL, outR);
+
+            for (long i = 0; i < kFrames; i++)
+            {
+                if (std::memcmp(&outL[i], &refL[i], sizeof(float)) || std::memcmp(&outR[i], &refR[i], sizeof(float)))
+                {
+                    std::fprintf(stderr, "%s, block %u%s: differs from block 1 at frame %ld\n",
+                                 settings[s].name, blockSize, planner ? " planner" : "", i);
+                    ++failures;
+                    break;
+                }
+            }
+        }
+    }
+
+    if (failures)
+    {
+        std::fprintf(stderr, "test-blocksize: %d failure(s)\n", failures);
+        return 1;
+    }
+    std::printf("test-blocksize: ok\n");
+    return 0;
+}
@@ -0,0 +1,207 @@
+/*
+ This file is part of Livecut
+ Copyright 2004 by Remy Muller.
+ Adapted for DISTRHO Plugin Framework (DPF) by eventual-recluse.
+
+ Livecut can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+
+ Livecut is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Livecut; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA 02111-1307 USA
+ */
+
+/* test-delayline: the block methods of the delay lines against their per-sample versions */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "BBCutter.h"
+#include "DelayLine.h"
+
+// the per-sample reads round their position to a float, far into the line
+// that is a few 1e-4 samples off the exact position the block reads use
+static const float kTolerance = 1e-3f;
+
+static int failures = 0;
+
+static void check(bool ok, const char* what, const char* sizing, float delay, long at)
+{
+    if (ok) return;
+    if (failures < 20)
+        std::fprintf(stderr, "%s, %s line, delay %g: wrong at %ld\n", what, sizing, delay, at);
+    ++failures;
+}
+
+static inline bool close(float a, float b)
+{
+    return std::fabs(a - b) <= kTolerance;
+}
+
+static void fill(Random& rng, std::vector<float>& x, long n)
+{
+    x.resize(n);
+    for (long i = 0; i < n; i++)
+        x[i] = (float)rng.randomfloat(-1.0, 1.0);
+}
+
+/**
+  Block tick() against tick() per sample, and the span tapL() against tapL() per sample,
+  with blocks of any length so that they run across the end of the buffer many times.
+ */
+static void test_tick(long size, long sizing, const char* name, float delay)
+{
+    Random rng(7, 1);
+    DelayLine a(delay, size, sizing), ar(delay, size, sizing), b(delay, size, sizing);
+    StereoDelayLine sa(delay, size, sizing), sb(delay, size, sizing);
+    const long length = a.size();
+
+    std::vector<float> x, xr, y, yr, zl, zr, ol, orr, span, spanl, spanr;
+    for (long block = 0; block < 200; block++)
+    {
+        const long n = rng.randominteger(1, 3 * length);
+        fill(rng, x, n);
+        fill(rng, xr, n);
+        y.resize(n);
+        yr.resize(n);
+        zl.resize(n);
+        zr.resize(n);
+        ol.resize(n);
+        orr.resize(n);
+
+        for (long i = 0; i < n; i++)
+        {
+            y[i] = a.tick(x[i]);
+            yr[i] = ar.tick(xr[i]);
+            sa.tick(zl[i], zr[i], x[i], xr[i]);
+        }
+        sb.tick(&x[0], &xr[0], &ol[0], &orr[0], (int)n);
+        b.tick(&x[0], &x[0], (int)n); // in place
+
+        for (long i = 0; i < n; i++)
+        {
+            check(close(x[i], y[i]), "DelayLine block tick", name, delay, i);
+            check(close(zl[i], y[i]) && close(zr[i], yr[i]), "StereoDelayLine tick", name, delay, i);
+            check(close(ol[i], zl[i]) && close(orr[i], zr[i]), "StereoDelayLine block tick", name, delay, i);
+        }
+        check(close(b.lastOut(), a.lastOut()), "DelayLine block tick last out", name, delay, n);
+        check(close(sb.lastOutL(), sa.lastOutL()) && close(sb.lastOutR(), sa.lastOutR()),
+              "StereoDelayLine block tick last out", name, delay, n);
+
+        // dest[i] = tapL(samples-i), from the oldest samples up to the newest
+        const long m = rng.randominteger(1, length / 2);
+        const float samples = std::min((float)rng.randomfloat((double)m, (double)length), float(length - 1));
+        span.resize(m);
+        spanl.resize(m);
+        spanr.resize(m);
+        b.tapL(&span[0], samples, (int)m);
+        sb.tapL(&spanl[0], &spanr[0], samples, (int)m);
+        for (long i = 0; i < m; i++)
+        {
+            check(close(span[i], a.tapL(samples - i)), "DelayLine span tapL", name, samples, i);
+            check(close(spanl[i], a.tapL(samples - i)) && close(spanr[i], ar.tapL(samples - i)),
+                  "StereoDelayLine span tapL", name, samples, i);
+        }
+    }
+}
+
+/**
+  Block and per-sample write(), then read() and tap() against what was written,
+  including the spans that wrap around the end of the buffer.
+ */
+static void test_write_read(long size, long sizing, const char* name)
+{
+    Random rng(3, 2);
+    DelayLine d(1, size, sizing);
+    StereoDelayLine s(1, size, sizing);
+    const long length = d.size();
+
+    std::vector<float> historyL, historyR, x, xr, dest, destl, destr;
+    for (long block = 0; block < 500; block++)
+    {
+        const long n = rng.randominteger(1, length + length / 2);
+        fill(rng, x, n);
+        fill(rng, xr, n);
+        if (block % 2)
+        {
+            d.write(&x[0], (int)n);
+            s.write(&x[0], &xr[0], (int)n);
+        }
+        else
+        {
+            for (long i = 0; i < n; i++)
+            {
+                d.write(x[i]);
+                s.write(x[i], xr[i]);
+            }
+        }
+        historyL.insert(historyL.end(), x.begin(), x.end());
+        historyR.insert(historyR.end(), xr.begin(), xr.end());
+        const long written = (long)historyL.size();
+
+        // m samples from back samples ago
+        const long m = rng.randominteger(1, length);
+        const long back = rng.randominteger(m, length);
+        dest.resize(m);
+        destl.resize(m);
+        destr.resize(m);
+        d.read(&dest[0], (int)-back, (int)m);
+        s.read(&destl[0], &destr[0], (int)-back, (int)m);
+        for (long i = 0; i < m; i++)
+        {
+            const long k = written - back + i;
+            const float l = (k < 0) ? 0.f : historyL[k];
+            const float r = (k < 0) ? 0.f : historyR[k];
+            check(dest[i] == l, "DelayLine read", name, (float)back, i);
+            check(destl[i] == l && destr[i] == r, "StereoDelayLine read", name, (float)back, i);
+        }
+
+        for (long t = 1; t <= length && t <= written; t++)
+        {
+            const float* frame = s.tap(t);
+            check(d.tap(t) == historyL[written - t], "DelayLine tap", name, (float)t, written);
+            check(frame[0] == historyL[written - t] && frame[1] == historyR[written - t],
+                  "StereoDelayLine tap", name, (float)t, written);
+        }
+    }
+}
+
+int main()
+{
+    // an odd size, kept as is or rounded by either rule, the same way by both lines
+    static const long size = 1001;
+    static const long sizings[] = { DelayLine::Exact, DelayLine::PowerOf2, DelayLine::NextPowerOf2 };
+    static const long lengths[] = { 1001, 2048, 1024 };
+    static const char* names[] = { "exact", "power of 2", "next power of 2" };
+    // under one sample, fractions away from the .5 rounding ties, and past the end
+    static const float delays[] = { 0.3f, 1.513f, 17.013f, 400.013f, 998.013f, 5000.f };
+
+    for (int s = 0; s < 3; s++)
+    {
+        const DelayLine mono(1, size, sizings[s]);
+        const StereoDelayLine stereo(1, size, sizings[s]);
+        check(mono.size() == lengths[s], "DelayLine size", names[s], 1, mono.size());
+        check(stereo.size() == lengths[s], "StereoDelayLine size", names[s], 1, stereo.size());
+
+        for (unsigned i = 0; i < sizeof(delays)/sizeof(delays[0]); i++)
+            test_tick(size, sizings[s], names[s], delays[i]);
+        test_write_read(size, sizings[s], names[s]);
+    }
+
+    if (failures)
+    {
+        std::fprintf(stderr, "test-delayline: %d failure(s)\n", failures);
+        return 1;
+    }
+    std::printf("test-delayline: ok\n");
+    return 0;
+}
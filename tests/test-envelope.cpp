@@ -0,0 +1,94 @@
+/*
+ This file is part of Livecut
+ Copyright 2004 by Remy Muller.
+ Adapted for DISTRHO Plugin Framework (DPF) by eventual-recluse.
+
+ Livecut can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+
+ Livecut is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Livecut; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA 02111-1307 USA
+ */
+
+/* test-envelope: the tabulated cut envelope against the exp() it replaces */
+
+#include <cmath>
+#include <cstdio>
+
+#include "BBCutter.h"
+
+static double expenv(double i, double fade, double size)
+{
+  return (1.0-exp(-5.0*i/fade)) * (1.0-exp(5.0*(i-size)/fade));
+}
+
+int main()
+{
+  static const long maxcutlength = 20000;
+  static const long maxfade = 10000;
+  static const float fades[] = { 0.5f, 1.f, 7.f, 44.1f, 441.f, 2205.f, 4410.f, 10000.f, 3.f };
+  static const long lengths[] = { 1, 2, 3, 100, 1023, 4410, 15000, maxcutlength };
+
+  LivePlayer player;
+  player.SetMaxCutLength(maxcutlength, maxfade);
+
+  int failures = 0;
+  for (unsigned f = 0; f < sizeof(fades)/sizeof(fades[0]); ++f)
+  {
+    // growing and shrinking fades reuse the same table
+    player.SetFade(fades[f]);
+    // the player keeps whole samples, at least one
+    const double fade = fades[f] < 1.f ? 1.0 : double(long(fades[f]));
+
+    for (unsigned l = 0; l < sizeof(lengths)/sizeof(lengths[0]); ++l)
+    {
+      const long length = lengths[l];
+      double worst = 0.0;
+      long worsti = 0;
+      for (long i = 0; i < length; ++i)
+      {
+        const double err = std::fabs(double(player.envelope(i, length)) - expenv(double(i), fade, double(length)));
+        if (err > worst)
+        {
+          worst = err;
+          worsti = i;
+        }
+      }
+      if (worst > 1e-5)
+      {
+        std::fprintf(stderr, "fade %g length %ld: error %g at %ld\n", fade, length, worst, worsti);
+        ++failures;
+      }
+    }
+  }
+
+  // shrinking the player below the fade still covers every cut
+  player.SetFade(10000.f);
+  player.SetMaxCutLength(100, maxfade);
+  for (long i = 0; i < 100; ++i)
+  {
+    const double err = std::fabs(double(player.envelope(i, 100)) - expenv(double(i), 10000.0, 100.0));
+    if (err > 1e-5)
+    {
+      std::fprintf(stderr, "short player: error %g at %ld\n", err, i);
+      ++failures;
+      break;
+    }
+  }
+
+  if (failures)
+  {
+    std::fprintf(stderr, "test-envelope: %d failure(s)\n", failures);
+    return 1;
+  }
+  std::printf("test-envelope: ok\n");
+  return 0;
+}
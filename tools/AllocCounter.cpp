@@ -0,0 +1,152 @@
+/*
+ This file is part of Livecut
+ Copyright 2004 by Remy Muller.
+ Adapted for DISTRHO Plugin Framework (DPF) by eventual-recluse.
+
+ Livecut can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+
+ Livecut is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Livecut; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA 02111-1307 USA
+ */
+
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <new>
+
+#include "AllocCounter.hpp"
+
+static std::atomic<uint64_t> allocations(0);
+
+// zero-initialised, so reading them in the allocator doesn't allocate
+static thread_local bool guardArmed;
+static thread_local uint64_t guardAllocations;
+static thread_local size_t guardFirstSize;
+
+static inline void count_allocation(size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (guardArmed)
+    {
+        if (guardAllocations++ == 0) guardFirstSize = size;
+    }
+}
+
+uint64_t allocation_count()
+{
+    return allocations.load(std::memory_order_relaxed);
+}
+
+void arm_allocation_guard()
+{
+    guardAllocations = 0;
+    guardFirstSize = 0;
+    guardArmed = true;
+}
+
+uint64_t disarm_allocation_guard(size_t* firstSize)
+{
+    guardArmed = false;
+    if (firstSize) *firstSize = guardFirstSize;
+    return guardAllocations;
+}
+
+#if defined(__GLIBC__)
+
+// interpose the C allocator, glibc exports the real one under these names
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+
+void* malloc(size_t size)
+{
+    count_allocation(size);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size)
+{
+    count_allocation(count * size);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size)
+{
+    count_allocation(size);
+    return __libc_realloc(ptr, size);
+}
+
+void* memalign(size_t alignment, size_t size)
+{
+    count_allocation(size);
+    return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size)
+{
+    count_allocation(size);
+    return __libc_memalign(alignment, size);
+}
+
+// with glibc's semantics: *ptr is only set on success, and size 0 may give NULL
+int posix_memalign(void** ptr, size_t alignment, size_t size)
+{
+    if (alignment == 0 || alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0)
+        return EINVAL;
+    count_allocation(size);
+    void* p = __libc_memalign(alignment, size);
+    if (!p && size != 0)
+        return ENOMEM;
+    *ptr = p;
+    return 0;
+}
+}
+
+// operator new goes through malloc and is counted there
+#define COUNT_NEW(size)
+
+#else
+
+#define COUNT_NEW(size) count_allocation(size)
+
+#endif
+
+void* operator new(size_t size)
+{
+    COUNT_NEW(size);
+    void* p = std::malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    COUNT_NEW(size);
+    return std::malloc(size ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return operator new(size, std::nothrow);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
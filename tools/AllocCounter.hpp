@@ -0,0 +1,44 @@
+/*
+ This file is part of Livecut
+ Copyright 2004 by Remy Muller.
+ Adapted for DISTRHO Plugin Framework (DPF) by eventual-recluse.
+
+ Livecut can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+
+ Livecut is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Livecut; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA 02111-1307 USA
+ */
+
+/* Heap allocation counting for the tools, linking AllocCounter.cpp replaces the global allocator */
+
+#ifndef LIVECUT_ALLOC_COUNTER_HPP
+#define LIVECUT_ALLOC_COUNTER_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+  Number of heap allocations made by all threads since the start of the program.
+  With glibc this counts malloc, calloc, realloc and the aligned variants, which
+  also covers operator new; elsewhere only operator new is counted.
+ */
+uint64_t allocation_count();
+
+/**
+  Count the allocations made by the calling thread until the guard is disarmed,
+  to check that a section of code, e.g. LiveCutEngine::run(), never touches the heap.
+  disarm_allocation_guard() returns the number of allocations and the size of the first one.
+ */
+void arm_allocation_guard();
+uint64_t disarm_allocation_guard(size_t* firstSize = nullptr);
+
+#endif
@@ -0,0 +1,194 @@
+/*
+ This file is part of Livecut
+ Copyright 2004 by Remy Muller.
+ Adapted for DISTRHO Plugin Framework (DPF) by eventual-recluse.
+
+ Livecut can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+
+ Livecut is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Livecut; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA 02111-1307 USA
+ */
+
+#include <cstdio>
+#include <cstdlib>
+
+#include "Render.hpp"
+#include "LiveCutEngine.hpp"
+#include "WavFile.hpp"
+
+// the DSP load meters are outputs of the plugin, not parameters of the engine
+static bool is_output(int index)
+{
+    return index == LVC_LOAD || index == LVC_LOADPEAK;
+}
+
+int find_parameter(const std::string& name)
+{
+    char* end;
+    const long index = std::strtol(name.c_str(), &end, 10);
+    if (!name.empty() && !*end)
+        return (index >= 0 && index < LVC_CONTROL_NR && !is_output(index)) ? (int)index : -1;
+
+    for (int i = 0; i < LVC_CONTROL_NR; i++)
+    {
+        const std::string symbol = LVC_SYMBOLS[i];
+        if (is_output(i)) continue;
+        if (name == symbol || name == symbol.substr(std::string("livecut_").size()))
+            return i;
+    }
+    return -1;
+}
+
+static bool parse_number(const std::string& text, double& value)
+{
+    char* end;
+    value = std::strtod(text.c_str(), &end);
+    return !text.empty() && !*end;
+}
+
+bool parse_option(RenderJob& job, const std::string& option, std::string& error)
+{
+    const size_t eq = option.find('=');
+    const std::string name = option.substr(0, eq);
+    const std::string text = (eq == std::string::npos) ? std::string() : option.substr(eq + 1);
+    double value;
+
+    if (name == "meter")
+    {
+        if (std::sscanf(text.c_str(), "%lf/%lf", &job.beatsPerBar, &job.beatType) != 2
+            || job.beatsPerBar <= 0.0 || job.beatType <= 0.0)
+        {
+            error = "invalid meter '" + text + "'";
+            return false;
+        }
+        return true;
+    }
+
+    if (!parse_number(text, value))
+    {
+        error = "invalid value in '" + option + "'";
+        return false;
+    }
+
+    if (name == "bpm")
+    {
+        if (value <= 0.0)
+        {
+            error = "invalid tempo '" + text + "'";
+            return false;
+        }
+        job.bpm = value;
+    }
+    else if (name == "block")
+    {
+        if (value < 1.0 || value > 1048576.0)
+        {
+            error = "invalid block size '" + text + "'";
+            return false;
+        }
+        job.blockSize = (uint32_t)value;
+    }
+    else if (name == "bits")
+    {
+        if (value != 16.0 && value != 24.0 && value != 32.0)
+        {
+            error = "invalid sample format '" + text + "'";
+            return false;
+        }
+        job.bits = (uint16_t)value;
+    }
+    else
+    {
+        const int index = find_parameter(name);
+        if (index < 0)
+        {
+            error = "unknown parameter '" + name + "'";
+            return false;
+        }
+        job.parameters.push_back(std::make_pair(index, (float)value));
+    }
+    return true;
+}
+
+void list_parameters()
+{
+    for (uint32_t i = 0; i < LVC_CONTROL_NR; i++)
+        if (!is_output(i))
+            std::printf("%2u %-18s %10g  [%g, %g]\n", i, LVC_SYMBOLS[i], LVC_DEFAULTS[i],
+                        controlLimits[i].first, controlLimits[i].second);
+}
+
+bool render(const RenderJob& job, std::string& error, uint64_t* frames)
+{
+    WavReader input;
+    if (!input.open(job.input.c_str()))
+    {
+        error = "can't read '" + job.input + "' (16/24/32 bit PCM or 32 bit float, mono or stereo)";
+        return false;
+    }
+
+    WavWriter output;
+    if (!output.open(job.output.c_str(), input.sampleRate(), job.bits))
+    {
+        error = "can't write '" + job.output + "'";
+        return false;
+    }
+
+    const double sampleRate = input.sampleRate();
+
+    LiveCutEngine engine;
+    engine.set_sample_rate(sampleRate);
+    engine.set_planner_enabled(job.usePlanner);
+    engine.set_profiling(job.profile);
+    for (size_t i = 0; i < job.parameters.size(); i++)
+    {
+        const int index = job.parameters[i].first;
+        engine.set_parameter(index, limit(job.parameters[i].second, controlLimits[index].first, controlLimits[index].second));
+    }
+    engine.activate();
+
+    std::vector<float> left(job.blockSize), right(job.blockSize);
+    uint64_t frame = 0;
+    bool ok = true;
+    for (;;)
+    {
+        const uint32_t n = input.read(left.data(), right.data(), job.blockSize);
+        if (n == 0) break;
+
+        // a host playing from the song start at a constant tempo
+        const LiveCutTransport transport = { job.bpm, job.beatsPerBar, job.beatType, frame / sampleRate * job.bpm / 60.0, frame };
+        engine.run(left.data(), right.data(), left.data(), right.data(), n, transport);
+
+        if (!output.write(left.data(), right.data(), n))
+        {
+            ok = false;
+            break;
+        }
+        frame += n;
+    }
+
+    engine.deactivate();
+
+    if (job.profile)
+    {
+        std::fprintf(stderr, "%s:\n", job.output.c_str());
+        engine.profiler().dump(stderr);
+    }
+
+    if (!output.close() || !ok)
+    {
+        error = "error writing '" + job.output + "'";
+        return false;
+    }
+    if (frames) *frames = frame;
+    return true;
+}
@@ -0,0 +1,75 @@
+/*
+ This file is part of Livecut
+ Copyright 2004 by Remy Muller.
+ Adapted for DISTRHO Plugin Framework (DPF) by eventual-recluse.
+
+ Livecut can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+
+ Livecut is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Livecut; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA 02111-1307 USA
+ */
+
+/* Offline rendering of one WAV file, shared by livecut-render and livecut-batch */
+
+#ifndef LIVECUT_RENDER_HPP
+#define LIVECUT_RENDER_HPP
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+  Everything needed to render one file. Each job gets its own LiveCutEngine,
+  so jobs can run concurrently.
+ */
+struct RenderJob
+{
+    std::string input;
+    std::string output;
+    double bpm;
+    double beatsPerBar;
+    double beatType;
+    uint32_t blockSize;
+    uint16_t bits;               // 16, 24 or 32 (float)
+    bool usePlanner;
+    bool profile;                // print the run() profile to stderr when done
+    std::vector<std::pair<int, float> > parameters; // applied in order, after the defaults
+
+    RenderJob() : bpm(120.0), beatsPerBar(4.0), beatType(4.0), blockSize(4096), bits(32), usePlanner(false), profile(false) {}
+};
+
+/**
+  Look up a parameter by symbol, with or without the livecut_ prefix, or by index.
+  Returns -1 when there is no such parameter.
+ */
+int find_parameter(const std::string& name);
+
+/**
+  Parse one NAME=VALUE option shared by the command line and the batch manifest:
+  bpm, meter (N/D), seed, block, bits or any parameter name.
+  Returns false and sets error when the option is invalid.
+ */
+bool parse_option(RenderJob& job, const std::string& option, std::string& error);
+
+/**
+  Print the parameters with their default and range.
+ */
+void list_parameters();
+
+/**
+  Render the job, returns false and sets error on failure.
+  The number of frames rendered is stored in frames when not null.
+ */
+bool render(const RenderJob& job, std::string& error, uint64_t* frames = nullptr);
+
+#endif
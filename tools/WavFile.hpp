@@ -0,0 +1,270 @@
+/*
+ This file is part of Livecut
+ Copyright 2004 by Remy Muller.
+ Adapted for DISTRHO Plugin Framework (DPF) by eventual-recluse.
+
+ Livecut can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+
+ Livecut is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Livecut; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA 02111-1307 USA
+ */
+
+/* Minimal streaming RIFF/WAVE reader and writer for the offline tools */
+
+#ifndef LIVECUT_WAVFILE_HPP
+#define LIVECUT_WAVFILE_HPP
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+/**
+  Reads 16, 24 and 32 bit integer or 32 bit float PCM, mono or stereo.
+  Mono files are returned on both channels.
+ */
+class WavReader
+{
+public:
+    WavReader() : file(nullptr), channels(0), bits(0), isFloat(false), rate(0), frames(0), remaining(0) {}
+    ~WavReader() { close(); }
+
+    bool open(const char* path)
+    {
+        close();
+        file = std::fopen(path, "rb");
+        if (!file) return false;
+
+        char riff[12];
+        if (std::fread(riff, 1, 12, file) != 12 || std::memcmp(riff, "RIFF", 4) || std::memcmp(riff + 8, "WAVE", 4))
+            return fail();
+
+        bool haveFormat = false;
+        for (;;)
+        {
+            char id[4];
+            uint8_t size[4];
+            if (std::fread(id, 1, 4, file) != 4 || std::fread(size, 1, 4, file) != 4)
+                return fail();
+            const uint32_t chunkSize = get32(size);
+
+            if (!std::memcmp(id, "fmt ", 4))
+            {
+                if (chunkSize < 16) return fail();
+                std::vector<uint8_t> fmt(chunkSize + (chunkSize & 1));
+                if (std::fread(fmt.data(), 1, fmt.size(), file) != fmt.size()) return fail();
+
+                uint16_t format = get16(&fmt[0]);
+                channels = get16(&fmt[2]);
+                rate     = get32(&fmt[4]);
+                bits     = get16(&fmt[14]);
+                // WAVE_FORMAT_EXTENSIBLE, the subformat GUID starts with the format tag
+                if (format == 0xFFFE && chunkSize >= 26) format = get16(&fmt[24]);
+
+                isFloat = (format == 3);
+                if ((format != 1 && format != 3) || channels < 1 || channels > 2 || rate == 0) return fail();
+                if (isFloat ? bits != 32 : (bits != 16 && bits != 24 && bits != 32)) return fail();
+                haveFormat = true;
+            }
+            else if (!std::memcmp(id, "data", 4))
+            {
+                if (!haveFormat) return fail();
+                frames = remaining = chunkSize / frameBytes();
+                return true;
+            }
+            else if (std::fseek(file, chunkSize + (chunkSize & 1), SEEK_CUR))
+            {
+                return fail();
+            }
+        }
+    }
+
+    void close()
+    {
+        if (file) std::fclose(file);
+        file = nullptr;
+    }
+
+    /**
+      Read up to n frames, returns the number of frames read.
+    */
+    uint32_t read(float* left, float* right, uint32_t n)
+    {
+        if (n > remaining) n = (uint32_t)remaining;
+        raw.resize((size_t)n * frameBytes());
+        n = (uint32_t)(std::fread(raw.data(), 1, raw.size(), file) / frameBytes());
+        remaining -= n;
+
+        const uint8_t* p = raw.data();
+        const uint32_t bytes = bits / 8;
+        for (uint32_t i = 0; i < n; i++)
+        {
+            left[i] = sample(p);
+            p += bytes;
+            if (channels == 2)
+            {
+                right[i] = sample(p);
+                p += bytes;
+            }
+            else
+            {
+                right[i] = left[i];
+            }
+        }
+        return n;
+    }
+
+    uint32_t sampleRate() const { return rate; }
+    uint64_t length() const { return frames; }
+
+private:
+    static uint16_t get16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+    static uint32_t get32(const uint8_t* p) { return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24); }
+
+    bool fail()
+    {
+        close();
+        return false;
+    }
+
+    uint32_t frameBytes() const { return channels * (bits / 8); }
+
+    float sample(const uint8_t* p) const
+    {
+        if (isFloat)
+        {
+            const uint32_t u = get32(p);
+            float f;
+            std::memcpy(&f, &u, sizeof(f));
+            return f;
+        }
+        switch (bits)
+        {
+            case 16: return (int16_t)get16(p) * (1.0f / 32768.0f);
+            case 24: return (int32_t)(((uint32_t)p[0] << 8) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 24)) * (1.0f / 2147483648.0f);
+            default: return (int32_t)get32(p) * (1.0f / 2147483648.0f);
+        }
+    }
+
+    FILE* file;
+    uint16_t channels;
+    uint16_t bits;
+    bool isFloat;
+    uint32_t rate;
+    uint64_t frames;
+    uint64_t remaining;
+    std::vector<uint8_t> raw;
+};
+
+/**
+  Writes stereo 16 or 24 bit integer or 32 bit float PCM.
+  The chunk sizes are patched on close().
+ */
+class WavWriter
+{
+public:
+    WavWriter() : file(nullptr), bits(0), frames(0) {}
+    ~WavWriter() { close(); }
+
+    bool open(const char* path, uint32_t rate, uint16_t bitsPerSample)
+    {
+        close();
+        if (bitsPerSample != 16 && bitsPerSample != 24 && bitsPerSample != 32) return false;
+        file = std::fopen(path, "wb");
+        if (!file) return false;
+
+        bits = bitsPerSample;
+        frames = 0;
+
+        const uint16_t blockAlign = 2 * (bits / 8);
+        uint8_t header[44];
+        std::memcpy(header, "RIFF", 4);
+        put32(header + 4, 36);
+        std::memcpy(header + 8, "WAVEfmt ", 8);
+        put32(header + 16, 16);
+        put16(header + 20, bits == 32 ? 3 : 1);
+        put16(header + 22, 2);
+        put32(header + 24, rate);
+        put32(header + 28, rate * blockAlign);
+        put16(header + 32, blockAlign);
+        put16(header + 34, bits);
+        std::memcpy(header + 36, "data", 4);
+        put32(header + 40, 0);
+        return std::fwrite(header, 1, sizeof(header), file) == sizeof(header);
+    }
+
+    bool write(const float* left, const float* right, uint32_t n)
+    {
+        const uint32_t bytes = bits / 8;
+        raw.resize((size_t)n * 2 * bytes);
+        uint8_t* p = raw.data();
+        for (uint32_t i = 0; i < n; i++)
+        {
+            sample(p, left[i]);
+            sample(p + bytes, right[i]);
+            p += 2 * bytes;
+        }
+        frames += n;
+        return std::fwrite(raw.data(), 1, raw.size(), file) == raw.size();
+    }
+
+    bool close()
+    {
+        if (!file) return true;
+
+        const uint64_t dataBytes = frames * 2 * (bits / 8);
+        uint8_t size[4];
+        bool ok = dataBytes + 36 <= 0xFFFFFFFFu;
+        put32(size, (uint32_t)(dataBytes + 36));
+        ok = ok && !std::fseek(file, 4, SEEK_SET) && std::fwrite(size, 1, 4, file) == 4;
+        put32(size, (uint32_t)dataBytes);
+        ok = ok && !std::fseek(file, 40, SEEK_SET) && std::fwrite(size, 1, 4, file) == 4;
+        ok = (std::fclose(file) == 0) && ok;
+        file = nullptr;
+        return ok;
+    }
+
+private:
+    static void put16(uint8_t* p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+    static void put32(uint8_t* p, uint32_t v) { put16(p, (uint16_t)v); put16(p + 2, (uint16_t)(v >> 16)); }
+
+    void sample(uint8_t* p, float x) const
+    {
+        if (bits == 32)
+        {
+            uint32_t u;
+            std::memcpy(&u, &x, sizeof(u));
+            put32(p, u);
+            return;
+        }
+        x = x < -1.0f ? -1.0f : (x > 1.0f ? 1.0f : x);
+        if (bits == 16)
+        {
+            put16(p, (uint16_t)(int16_t)lrintf(x * 32767.0f));
+        }
+        else
+        {
+            const int32_t v = (int32_t)lrintf(x * 8388607.0f);
+            p[0] = (uint8_t)v;
+            p[1] = (uint8_t)(v >> 8);
+            p[2] = (uint8_t)(v >> 16);
+        }
+    }
+
+    FILE* file;
+    uint16_t bits;
+    uint64_t frames;
+    std::vector<uint8_t> raw;
+};
+
+#endif
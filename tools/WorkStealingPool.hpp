@@ -0,0 +1,125 @@
+/*
+ This file is part of Livecut
+ Copyright 2004 by Remy Muller.
+ Adapted for DISTRHO Plugin Framework (DPF) by eventual-recluse.
+
+ Livecut can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+
+ Livecut is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Livecut; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA 02111-1307 USA
+ */
+
+/* Work-stealing thread pool for running a fixed set of independent tasks */
+
+#ifndef LIVECUT_WORK_STEALING_POOL_HPP
+#define LIVECUT_WORK_STEALING_POOL_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+  Runs tasks 0..count-1 on a number of threads. The tasks are dealt out in
+  contiguous ranges, one queue per thread; a thread works through its own
+  queue from the front and, once it is empty, steals from the back of the
+  other queues. The tasks are coarse (a whole file each) so a lock per
+  queue is cheap and only contended while stealing.
+ */
+class WorkStealingPool
+{
+public:
+    explicit WorkStealingPool(unsigned threads)
+        : threadCount(threads > 0 ? threads : 1)
+    {
+    }
+
+    static unsigned default_threads()
+    {
+        const unsigned n = std::thread::hardware_concurrency();
+        return n > 0 ? n : 1;
+    }
+
+    /**
+      Call task(index, thread) for every index in [0, count), returns when all are done.
+    */
+    void run(size_t count, const std::function<void(size_t, unsigned)>& task)
+    {
+        const unsigned threads = (unsigned)std::min<size_t>(threadCount, count > 0 ? count : 1);
+
+        queues.clear();
+        for (unsigned t = 0; t < threads; t++)
+        {
+            queues.emplace_back(new Queue);
+            for (size_t i = count * t / threads; i < count * (t + 1) / threads; i++)
+                queues[t]->tasks.push_back(i);
+        }
+
+        std::vector<std::thread> workers;
+        for (unsigned t = 1; t < threads; t++)
+            workers.emplace_back(&WorkStealingPool::work, this, t, std::cref(task));
+        work(0, task);
+        for (size_t t = 0; t < workers.size(); t++)
+            workers[t].join();
+
+        queues.clear();
+    }
+
+private:
+    struct Queue
+    {
+        std::mutex lock;
+        std::deque<size_t> tasks;
+    };
+
+    bool pop(unsigned t, size_t& index)
+    {
+        Queue& q = *queues[t];
+        std::lock_guard<std::mutex> guard(q.lock);
+        if (q.tasks.empty()) return false;
+        index = q.tasks.front();
+        q.tasks.pop_front();
+        return true;
+    }
+
+    bool steal(unsigned t, size_t& index)
+    {
+        const unsigned n = (unsigned)queues.size();
+        for (unsigned k = 1; k < n; k++)
+        {
+            Queue& q = *queues[(t + k) % n];
+            std::lock_guard<std::mutex> guard(q.lock);
+            if (q.tasks.empty()) continue;
+            index = q.tasks.back();
+            q.tasks.pop_back();
+            return true;
+        }
+        return false;
+    }
+
+    void work(unsigned t, const std::function<void(size_t, unsigned)>& task)
+    {
+        // no task adds new ones, so once every queue is empty the thread is done
+        size_t index;
+        while (pop(t, index) || steal(t, index))
+            task(index, t);
+    }
+
+    unsigned threadCount;
+    std::vector<std::unique_ptr<Queue> > queues;
+};
+
+#endif
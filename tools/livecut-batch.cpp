@@ -0,0 +1,219 @@
+/*
+ This file is part of Livecut
+ Copyright 2004 by Remy Muller.
+ Adapted for DISTRHO Plugin Framework (DPF) by eventual-recluse.
+
+ Livecut can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+
+ Livecut is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Livecut; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA 02111-1307 USA
+ */
+
+/* livecut-batch: renders the jobs of a manifest concurrently, one processing chain per job */
+
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Render.hpp"
+#include "WorkStealingPool.hpp"
+
+static void usage()
+{
+    std::fprintf(stderr,
+        "usage: livecut-batch [options] manifest.txt\n"
+        "  --threads N           number of render threads (default: all cores)\n"
+        "  --quiet               only report errors\n"
+        "\n"
+        "Each manifest line is either a job or a preset, # starts a comment:\n"
+        "  preset NAME OPTION...\n"
+        "  INPUT.wav OUTPUT.wav OPTION...\n"
+        "where OPTION is NAME=VALUE with NAME one of bpm, meter (N/D), seed, block, bits,\n"
+        "a parameter symbol (livecut_subdiv or subdiv) or index, or preset to apply the\n"
+        "options of a preset defined earlier. Paths with spaces can be double quoted.\n");
+}
+
+/**
+  Split a manifest line into whitespace separated tokens, with double quotes and # comments.
+ */
+static bool tokenize(const std::string& line, std::vector<std::string>& tokens)
+{
+    tokens.clear();
+    size_t i = 0;
+    while (i < line.size())
+    {
+        if (std::isspace((unsigned char)line[i])) { ++i; continue; }
+        if (line[i] == '#') break;
+
+        std::string token;
+        bool quoted = false;
+        while (i < line.size() && (quoted || !std::isspace((unsigned char)line[i])))
+        {
+            if (line[i] == '"')
+                quoted = !quoted;
+            else
+                token += line[i];
+            ++i;
+        }
+        if (quoted) return false;
+        tokens.push_back(token);
+    }
+    return true;
+}
+
+static bool apply_options(RenderJob& job, const std::vector<std::string>& tokens, size_t first,
+                          const std::map<std::string, std::vector<std::string> >& presets, std::string& error)
+{
+    for (size_t i = first; i < tokens.size(); i++)
+    {
+        if (tokens[i].compare(0, 7, "preset=") == 0)
+        {
+            const std::map<std::string, std::vector<std::string> >::const_iterator preset = presets.find(tokens[i].substr(7));
+            if (preset == presets.end())
+            {
+                error = "unknown preset '" + tokens[i].substr(7) + "'";
+                return false;
+            }
+            // presets are checked when they are defined and can't refer to later ones
+            if (!apply_options(job, preset->second, 0, presets, error))
+                return false;
+        }
+        else if (!parse_option(job, tokens[i], error))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool read_manifest(const char* path, std::vector<RenderJob>& jobs)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        std::fprintf(stderr, "livecut-batch: can't read '%s'\n", path);
+        return false;
+    }
+
+    std::map<std::string, std::vector<std::string> > presets;
+    std::vector<std::string> tokens;
+    std::string line, error;
+    for (int lineNumber = 1; std::getline(file, line); lineNumber++)
+    {
+        if (!tokenize(line, tokens))
+            error = "unbalanced quotes";
+        else if (tokens.empty())
+            continue;
+        else if (tokens[0] == "preset")
+        {
+            RenderJob check;
+            if (tokens.size() < 2)
+                error = "preset without a name";
+            else if (apply_options(check, tokens, 2, presets, error))
+                presets[tokens[1]] = std::vector<std::string>(tokens.begin() + 2, tokens.end());
+        }
+        else if (tokens.size() < 2)
+            error = "job without an output file";
+        else
+        {
+            RenderJob job;
+            job.input = tokens[0];
+            job.output = tokens[1];
+            if (apply_options(job, tokens, 2, presets, error))
+                jobs.push_back(job);
+        }
+
+        if (!error.empty())
+        {
+            std::fprintf(stderr, "livecut-batch: %s:%d: %s\n", path, lineNumber, error.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    unsigned threads = WorkStealingPool::default_threads();
+    bool quiet = false;
+    const char* manifest = nullptr;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!std::strcmp(argv[i], "--threads") && i + 1 < argc)
+            threads = (unsigned)std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--quiet"))
+            quiet = true;
+        else if (!std::strcmp(argv[i], "--help") || !std::strcmp(argv[i], "-h"))
+        {
+            usage();
+            return 0;
+        }
+        else if (!manifest && std::strncmp(argv[i], "--", 2))
+            manifest = argv[i];
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+
+    std::vector<RenderJob> jobs;
+    if (!manifest || threads == 0)
+    {
+        usage();
+        return 1;
+    }
+    if (!read_manifest(manifest, jobs))
+        return 1;
+
+    typedef std::chrono::steady_clock Clock;
+    const Clock::time_point start = Clock::now();
+
+    std::mutex reportLock;
+    std::atomic<unsigned> failed(0);
+    std::atomic<uint64_t> totalFrames(0);
+
+    WorkStealingPool pool(threads);
+    pool.run(jobs.size(), [&](size_t index, unsigned thread)
+    {
+        const Clock::time_point jobStart = Clock::now();
+        std::string error;
+        uint64_t frames = 0;
+        const bool ok = render(jobs[index], error, &frames);
+        const double seconds = std::chrono::duration<double>(Clock::now() - jobStart).count();
+
+        totalFrames += frames;
+        if (!ok) ++failed;
+
+        std::lock_guard<std::mutex> guard(reportLock);
+        if (!ok)
+            std::fprintf(stderr, "livecut-batch: job %zu: %s\n", index + 1, error.c_str());
+        else if (!quiet)
+            std::printf("[%2u] %s -> %s (%.2f s)\n", thread, jobs[index].input.c_str(), jobs[index].output.c_str(), seconds);
+    });
+
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    if (!quiet)
+        std::printf("%zu jobs, %u failed, %llu frames in %.2f s on %u threads\n", jobs.size(), failed.load(),
+                    (unsigned long long)totalFrames.load(), seconds, threads);
+
+    return failed ? 1 : 0;
+}
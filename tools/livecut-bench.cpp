@@ -0,0 +1,628 @@
+/*
+ This file is part of Livecut
+ Copyright 2004 by Remy Muller.
+ Adapted for DISTRHO Plugin Framework (DPF) by eventual-recluse.
+
+ Livecut can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+
+ Livecut is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Livecut; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA 02111-1307 USA
+ */
+
+/* livecut-bench: microbenchmarks of the DSP components, run with `make bench`,
+   and a check that the audio path never allocates, run with --alloc-guard */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "AllocCounter.hpp"
+#include "LiveCutControls.hpp"
+#include "LiveCutEngine.hpp"
+#include "BBCutter.h"
+#include "BitCrusher.h"
+#include "Comb.h"
+#include "DelayLine.h"
+#include "FirstOrderLowpass.h"
+
+typedef std::chrono::steady_clock Clock;
+
+static inline double elapsed_ns(Clock::time_point start, Clock::time_point end)
+{
+    return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+static const double kSampleRate = 44100.0;
+static const double kTempo = 120.0;
+
+// keeps the compiler from dropping the benchmarked work
+static volatile float sink;
+
+/**
+  Print one line of the report, worst < 0 for the components without cut boundaries.
+ */
+static void report(const std::string& name, double ns, double worst, uint64_t allocs, double totalNs)
+{
+    const double allocsPerSec = allocs / (totalNs * 1e-9);
+    if (worst >= 0.0)
+        std::printf("%-44s %10.2f %14.0f %12.1f\n", name.c_str(), ns, worst, allocsPerSec);
+    else
+        std::printf("%-44s %10.2f %14s %12.1f\n", name.c_str(), ns, "-", allocsPerSec);
+    std::fflush(stdout);
+}
+
+static void fill_noise(std::vector<float>& buffer, uint64_t seed)
+{
+    Random rng;
+    rng.seed(seed, 7);
+    for (size_t i = 0; i < buffer.size(); i++)
+        buffer[i] = (float)rng.randomfloat(-1.0, 1.0);
+}
+
+/**
+  Forwards the cutter callbacks to a component and accumulates the time spent in them.
+ */
+class TimedListener : public BBCutListener
+{
+public:
+    explicit TimedListener(BBCutListener& l) : listener(l), ns(0.0) {}
+
+    void OnPhrase(long bar, long sd) override { Clock::time_point t = Clock::now(); listener.OnPhrase(bar, sd); ns += elapsed_ns(t, Clock::now()); }
+    void OnBlock(long bar, long sd) override  { Clock::time_point t = Clock::now(); listener.OnBlock(bar, sd);  ns += elapsed_ns(t, Clock::now()); }
+    void OnUnit(long bar, long sd) override   { Clock::time_point t = Clock::now(); listener.OnUnit(bar, sd);   ns += elapsed_ns(t, Clock::now()); }
+    void OnCut(long cut, long numcuts) override { Clock::time_point t = Clock::now(); listener.OnCut(cut, numcuts); ns += elapsed_ns(t, Clock::now()); }
+
+    BBCutListener& listener;
+    double ns;
+};
+
+/**
+  Player and cutter set up like LiveCutEngine::activate(), stepped one unit at a time.
+ */
+struct Chain
+{
+    LivePlayer player;
+    BBCutter bbcutter;
+
+    Chain(long cutproc, long subdiv, float pitch)
+        : bbcutter(player)
+    {
+        bbcutter.SetSampleRate(kSampleRate);
+        bbcutter.SetTimeInfos(kTempo, 4.0, 4.0, kSampleRate);
+        player.SetMaxCutLength(bbcutter.MaxCutLength(), bbcutter.MaxFadeLength());
+        bbcutter.SetCutProc(cutproc);
+        bbcutter.SetSubdiv(subdiv);
+        bbcutter.SetFade(LVC_DEFAULTS[LVC_FADE]);
+        bbcutter.SetMinDetune(-pitch);
+        bbcutter.SetMaxDetune(pitch);
+        bbcutter.SetMinPhraseLength(1);
+        bbcutter.SetMaxPhraseLength(4);
+        bbcutter.SetSeed(1);
+        this->subdiv = subdiv;
+    }
+
+    // first frame of the unit, on the same grid as LiveCutEngine
+    int64_t unit_frame(long unit) const
+    {
+        const double spu = kSampleRate * 60.0 / kTempo * 4.0 / subdiv;
+        return (int64_t)std::ceil(unit * spu - 1e-6);
+    }
+
+    void set_unit(long unit)
+    {
+        bbcutter.SetPosition(unit / subdiv, unit % subdiv);
+    }
+
+    long subdiv;
+};
+
+static inline void effect_tick(BBCutListener&, float&, float&) {}
+static inline void effect_tick(BitCrusher& c, float& l, float& r) { c.tick(l, r, l, r); }
+static inline void effect_tick(Comb& c, float& l, float& r) { c.tick(l, r, l, r); }
+
+static inline void effect_process(BBCutListener&, float*, float*, long) {}
+static inline void effect_process(BitCrusher& c, float* l, float* r, long n) { c.process(l, r, n); }
+static inline void effect_process(Comb& c, float* l, float* r, long n) { c.process(l, r, n); }
+
+/**
+  LivePlayer::process over a span, in the pieces it returns at the end of each cut,
+  the way LiveCutEngine::run_span drives it.
+ */
+static void play_span(LivePlayer& player, const float* inL, const float* inR, float* outL, float* outR, long n)
+{
+    while (n > 0)
+    {
+        const long done = player.process(inL, inR, outL, outR, n);
+        inL += done;
+        inR += done;
+        outL += done;
+        outR += done;
+        n -= done;
+    }
+}
+
+/**
+  Benchmark LivePlayer, or a cut-synchrone effect fed by the player when one is given.
+  The player or the effect runs per sample with tick(), or per unit with process() when block is set.
+  Per unit, the time for SetPosition() plus the effect's callbacks is the boundary cost.
+ */
+template <class Effect>
+static void bench_chain(const std::string& name, long cutproc, long subdiv, float pitch, long units,
+                        Effect* effect, bool block = false)
+{
+    Chain chain(cutproc, subdiv, pitch);
+    TimedListener* timed = nullptr;
+    if (effect)
+    {
+        timed = new TimedListener(*effect);
+        chain.bbcutter.RegisterListener(timed);
+    }
+
+    const int64_t frames = chain.unit_frame(units);
+    std::vector<float> inL(frames), inR(frames), bufL(frames), bufR(frames);
+    fill_noise(inL, 1);
+    fill_noise(inR, 2);
+
+    const uint64_t allocs = allocation_count();
+    const Clock::time_point start = Clock::now();
+    double tickNs = 0.0;
+    double worst = 0.0;
+
+    for (long unit = 0; unit < units; unit++)
+    {
+        const int64_t begin = chain.unit_frame(unit);
+        const int64_t end = chain.unit_frame(unit + 1);
+        double callbacks = timed ? timed->ns : 0.0;
+
+        Clock::time_point t0 = Clock::now();
+        chain.set_unit(unit);
+        Clock::time_point t1 = Clock::now();
+        double boundary = elapsed_ns(t0, t1);
+
+        if (!effect)
+        {
+            if (block)
+                play_span(chain.player, &inL[begin], &inR[begin], &bufL[begin], &bufR[begin], (long)(end - begin));
+            else
+                for (int64_t i = begin; i < end; i++)
+                    chain.player.tick(bufL[i], bufR[i], inL[i], inR[i]);
+            tickNs += elapsed_ns(t1, Clock::now());
+        }
+        else
+        {
+            for (int64_t i = begin; i < end; i++)
+                chain.player.tick(bufL[i], bufR[i], inL[i], inR[i]);
+
+            // only the effect's own callbacks count towards its boundary cost
+            boundary = timed->ns - callbacks;
+            Clock::time_point t2 = Clock::now();
+            if (block)
+                effect_process(*effect, &bufL[begin], &bufR[begin], (long)(end - begin));
+            else
+                for (int64_t i = begin; i < end; i++)
+                    effect_tick(*effect, bufL[i], bufR[i]);
+            tickNs += elapsed_ns(t2, Clock::now());
+        }
+        worst = std::max(worst, boundary);
+    }
+
+    const double total = elapsed_ns(start, Clock::now());
+    sink = bufL[frames - 1] + bufR[frames / 2];
+    report(name, tickNs / frames, worst, allocation_count() - allocs, total);
+    delete timed;
+}
+
+
+static void bench_player(long units)
+{
+    static const char* procs[] = { "CutProc11", "WarpCutProc", "SQPusher" };
+    static const long subdivs[] = { 8, 16, 32 };
+    for (int block = 0; block < 2; block++)
+        for (long p = 0; p < 3; p++)
+            for (long s = 0; s < 3; s++)
+                for (int pitched = 0; pitched < 2; pitched++)
+                {
+                    char name[64];
+                    std::snprintf(name, sizeof(name), "LivePlayer::%s %s /%ld%s", block ? "process" : "tick",
+                                  procs[p], subdivs[s], pitched ? " pitch" : "");
+                    bench_chain(name, p, subdivs[s], pitched ? 1200.f : 0.f, units, (BBCutListener*)nullptr, block != 0);
+                }
+}
+
+static void bench_crusher(long units)
+{
+    static const float bits[][2] = { { 32.f, 32.f }, { 4.f, 12.f }, { 1.f, 4.f } };
+    static const float freqs[][2] = { { 44100.f, 44100.f }, { 2000.f, 20000.f }, { 100.f, 1000.f } };
+    for (int i = 0; i < 6; i++)
+    {
+        const bool block = i >= 3;
+        BitCrusher crusher;
+        crusher.SetSampleRate(kSampleRate);
+        crusher.SetOn(true);
+        crusher.SetMinBits(bits[i % 3][0]);
+        crusher.SetMaxBits(bits[i % 3][1]);
+        crusher.SetMinFreq(freqs[i % 3][0]);
+        crusher.SetMaxFreq(freqs[i % 3][1]);
+        crusher.SetSeed(1);
+
+        char name[96];
+        std::snprintf(name, sizeof(name), "BitCrusher::%s %g-%g bits %g-%g Hz", block ? "process" : "tick",
+                      bits[i % 3][0], bits[i % 3][1], freqs[i % 3][0], freqs[i % 3][1]);
+        bench_chain(name, 0, 16, 0.f, units, &crusher, block);
+    }
+}
+
+static void bench_comb(long units)
+{
+    static const float delays[][2] = { { 1.f, 5.f }, { 10.f, 10.f }, { 5.f, 50.f } };
+    static const char* interpolations[] = { "linear", "allpass", "lagrange" };
+    // tick ff and fb, then process ff and fb with each interpolation
+    for (long v = 0; v < 6; v++)
+        for (int i = 0; i < 3; i++)
+        {
+            const bool block = v >= 2;
+            const long type = (v == 0 || v == 2) ? Comb::FeedForward : Comb::FeedBack;
+            const long interpolation = v > 2 ? v - 3 : Comb::Linear;
+
+            Comb comb;
+            comb.SetSampleRate(kSampleRate);
+            comb.SetOn(true);
+            comb.SetType(type);
+            comb.SetInterpolation(interpolation);
+            comb.SetFeedBack(0.5f);
+            comb.SetMinDelay(delays[i][0]);
+            comb.SetMaxDelay(delays[i][1]);
+            comb.SetSeed(1);
+
+            char name[64];
+            if (type == Comb::FeedForward)
+                std::snprintf(name, sizeof(name), "Comb::%s ff %g-%g ms", block ? "process" : "tick", delays[i][0], delays[i][1]);
+            else
+                std::snprintf(name, sizeof(name), "Comb::%s fb %s %g-%g ms", block ? "process" : "tick",
+                              interpolations[interpolation], delays[i][0], delays[i][1]);
+            bench_chain(name, 0, 16, 0.f, units, &comb, block);
+        }
+}
+
+static void bench_delayline(long frames)
+{
+    std::vector<float> in(frames);
+    fill_noise(in, 3);
+
+    static const float delays[] = { 44.1f, 441.f, 2205.5f };
+    for (int i = 0; i < 3; i++)
+    {
+        for (int modulated = 0; modulated < 2; modulated++)
+        {
+            DelayLine dl(delays[i], 4096);
+            dl.clear();
+            float acc = 0.f;
+
+            const uint64_t allocs = allocation_count();
+            const Clock::time_point start = Clock::now();
+            for (long n = 0; n < frames; n++)
+            {
+                if (modulated) dl.set_delay(delays[i] * (1.f + 0.5f * in[n & ~63L]));
+                acc += dl.tick(in[n]);
+            }
+            const double total = elapsed_ns(start, Clock::now());
+            sink = acc;
+
+            char name[64];
+            std::snprintf(name, sizeof(name), "DelayLine::tick %g%s", delays[i], modulated ? " modulated" : "");
+            report(name, total / frames, -1.0, allocation_count() - allocs, total);
+        }
+    }
+
+    // the block tick() at a fixed delay, 64 samples at a time
+    for (int i = 0; i < 3; i++)
+    {
+        DelayLine dl(delays[i], 4096);
+        dl.clear();
+        std::vector<float> out(frames);
+
+        const uint64_t allocs = allocation_count();
+        const Clock::time_point start = Clock::now();
+        for (long n = 0; n < frames; n += 64)
+            dl.tick(&in[n], &out[n], (int)std::min(64L, frames - n));
+        const double total = elapsed_ns(start, Clock::now());
+        sink = out[frames - 1];
+
+        char name[64];
+        std::snprintf(name, sizeof(name), "DelayLine::tick %g block", delays[i]);
+        report(name, total / frames, -1.0, allocation_count() - allocs, total);
+    }
+
+    // a second of delay, rounded up to a power of 2 or allocated as asked
+    for (long sizing = DelayLine::PowerOf2; sizing <= DelayLine::Exact; sizing++)
+    {
+        for (int modulated = 0; modulated < 2; modulated++)
+        {
+            DelayLine dl(22050.5f, (long)kSampleRate, sizing);
+            float acc = 0.f;
+
+            const uint64_t allocs = allocation_count();
+            const Clock::time_point start = Clock::now();
+            for (long n = 0; n < frames; n++)
+            {
+                if (modulated) dl.set_delay(22050.5f * (1.f + 0.5f * in[n & ~63L]));
+                acc += dl.tick(in[n]);
+            }
+            const double total = elapsed_ns(start, Clock::now());
+            sink = acc;
+
+            char name[64];
+            std::snprintf(name, sizeof(name), "DelayLine::tick %s %ld KB%s", sizing == DelayLine::Exact ? "exact" : "pow2",
+                          (dl.size() + DelayLine::kMirror) * (long)sizeof(float) / 1024, modulated ? " modulated" : "");
+            report(name, total / frames, -1.0, allocation_count() - allocs, total);
+        }
+    }
+
+    // per stereo frame, compare with twice DelayLine::tick
+    for (int i = 0; i < 3; i++)
+    {
+        for (int modulated = 0; modulated < 2; modulated++)
+        {
+            StereoDelayLine dl(delays[i], 4096);
+            float accL = 0.f, accR = 0.f;
+
+            const uint64_t allocs = allocation_count();
+            const Clock::time_point start = Clock::now();
+            for (long n = 0; n < frames; n++)
+            {
+                if (modulated) dl.set_delay(delays[i] * (1.f + 0.5f * in[n & ~63L]));
+                float l, r;
+                dl.tick(l, r, in[n], in[frames - 1 - n]);
+                accL += l;
+                accR += r;
+            }
+            const double total = elapsed_ns(start, Clock::now());
+            sink = accL + accR;
+
+            char name[64];
+            std::snprintf(name, sizeof(name), "StereoDelayLine::tick %g%s", delays[i], modulated ? " modulated" : "");
+            report(name, total / frames, -1.0, allocation_count() - allocs, total);
+        }
+    }
+}
+
+static void bench_lowpass(long frames)
+{
+    std::vector<float> in(frames);
+    fill_noise(in, 4);
+
+    static const float times[] = { 0.001f, 0.01f, 0.1f };
+    for (int i = 0; i < 3; i++)
+    {
+        FirstOrderLowpass lp;
+        lp.SetSampleRate(kSampleRate);
+        lp.SetTimeConstant(times[i]);
+        float acc = 0.f;
+
+        const uint64_t allocs = allocation_count();
+        const Clock::time_point start = Clock::now();
+        for (long n = 0; n < frames; n++)
+            acc += lp.tick(in[n]);
+        const double total = elapsed_ns(start, Clock::now());
+        sink = acc;
+
+        char name[64];
+        std::snprintf(name, sizeof(name), "FirstOrderLowpass::tick %g s", times[i]);
+        report(name, total / frames, -1.0, allocation_count() - allocs, total);
+    }
+}
+
+/**
+  ChooseCuts for one block at a time through whole phrases, per call.
+ */
+static void bench_choosecuts(long phrases)
+{
+    static const char* procs[] = { "CutProc11", "WarpCutProc", "SQPusher" };
+    static const long subdivs[] = { 8, 16, 32 };
+    static const float chances[] = { 0.2f, 0.8f };
+
+    for (long p = 0; p < 3; p++)
+        for (long s = 0; s < 3; s++)
+            for (int c = 0; c < 2; c++)
+            {
+                CutState state;
+                state.strategy = p;
+                state.seed = 1;
+                state.cutproc11.SetStutterChance(chances[c]);
+                state.cutproc11.SetMaxPhraseLength(4);
+                state.warpcutproc.SetStraightChance(1.f - chances[c]);
+                state.warpcutproc.SetMaxPhraseLength(4);
+                state.sqpusher.SetActivity(chances[c]);
+                state.sqpusher.SetMaxPhraseLength(4);
+
+                const long subdiv = subdivs[s];
+                const double spu = kSampleRate * 60.0 / kTempo * 4.0 / subdiv;
+                CutList cuts;
+                long calls = 0;
+                double worst = 0.0;
+
+                const uint64_t allocs = allocation_count();
+                const Clock::time_point start = Clock::now();
+                for (long phrase = 0; phrase < phrases; phrase++)
+                {
+                    const long totalunits = state.PhraseLength(phrase) * subdiv;
+                    for (long unitsdone = 0; unitsdone < totalunits; )
+                    {
+                        long unitsinblock = 0;
+                        const Clock::time_point t = Clock::now();
+                        state.ChooseCuts(cuts, unitsinblock, phrase, unitsdone, totalunits, subdiv, spu);
+                        worst = std::max(worst, elapsed_ns(t, Clock::now()));
+                        unitsdone += std::max(unitsinblock, 1L);
+                        ++calls;
+                    }
+                }
+                const double total = elapsed_ns(start, Clock::now());
+
+                char name[64];
+                std::snprintf(name, sizeof(name), "ChooseCuts %s /%ld %g", procs[p], subdivs[s], chances[c]);
+                report(name, total / calls, worst, allocation_count() - allocs, total);
+            }
+}
+
+/**
+  A parameter change from the host, inside the audio thread. Successive changes walk
+  through every input, each one between its limits and back, so the fade grows and
+  shrinks and the effects are switched on and off and change type while running.
+ */
+static void host_parameter_change(LiveCutEngine& engine, long change, uint32_t& index, float& value)
+{
+    static const float steps[] = { 1.0f, 0.0f, 0.5f, 0.25f, 1.0f, 0.75f, 0.0f };
+    index = (uint32_t)(change % LVC_LOAD);
+    const float step = steps[(change / LVC_LOAD) % 7];
+    value = controlLimits[index].first + step * (controlLimits[index].second - controlLimits[index].first);
+    engine.set_parameter(index, value);
+}
+
+/**
+  Drive the whole engine through every cut procedure, subdivision and pitch setting,
+  with tempo, meter, position and parameter changes, and fail on any allocation made by
+  set_parameter() or run(). Returns the number of audio callbacks that allocated.
+ */
+static long alloc_guard(long bars)
+{
+    static const double tempos[] = { 120.0, 174.0, 60.0, 97.3, 240.0, 41.0 };
+    static const double meters[][2] = { { 4.0, 4.0 }, { 3.0, 4.0 }, { 7.0, 8.0 }, { 5.0, 4.0 } };
+    static const uint32_t blockSizes[] = { 512, 64, 1000, 4096, 128 };
+    const double sampleRate = kSampleRate;
+
+    std::vector<float> inL(4096), inR(4096), outL(4096), outR(4096);
+    fill_noise(inL, 5);
+    fill_noise(inR, 6);
+
+    long failures = 0;
+    long calls = 0;
+    long changes = 0;
+    for (long cutproc = 0; cutproc < 3; cutproc++)
+        for (long subdiv = 0; subdiv < 7; subdiv++)
+            for (int pitched = 0; pitched < 2; pitched++)
+            {
+                LiveCutEngine engine;
+                engine.set_sample_rate(sampleRate);
+                engine.set_planner_enabled(pitched != 0);
+                engine.set_parameter(LVC_CUTPROC, cutproc);
+                engine.set_parameter(LVC_SUBDIV, subdiv);
+                engine.set_parameter(LVC_MINPITCH, pitched ? -1200.f : 0.f);
+                engine.set_parameter(LVC_MAXPITCH, pitched ? 1200.f : 0.f);
+                engine.set_parameter(LVC_MINPHRS, 1.f);
+                engine.set_parameter(LVC_MAXPHRS, 2.f);
+                engine.set_parameter(LVC_CRUSHER, 1.f);
+                engine.set_parameter(LVC_MINBITS, 4.f);
+                engine.set_parameter(LVC_MINFREQ, 2000.f);
+                engine.set_parameter(LVC_COMB, 1.f);
+                engine.set_parameter(LVC_TYPE, (float)pitched);
+                engine.set_parameter(LVC_MINDELAY, 1.f);
+                engine.set_parameter(LVC_MAXDELAY, 50.f);
+                engine.activate();
+
+                uint32_t lastIndex = LVC_SEED;
+                float lastValue = 0.f;
+                uint64_t frame = 0;
+                double beats = 0.0;
+                double barsDone = 0.0;
+                for (long change = 0; barsDone < bars; change++)
+                {
+                    // a new tempo, meter and block size every couple of bars
+                    const double bpm = tempos[change % 6];
+                    const double* meter = meters[change % 4];
+                    const uint32_t blockSize = blockSizes[change % 5];
+                    const double segmentBars = 2.0 + (change % 3);
+
+                    // and every few changes the host jumps back and forth
+                    if (change % 7 == 6)
+                    {
+                        beats = (change % 2) ? beats * 0.5 : beats + 13.25;
+                        frame += 1000;
+                    }
+
+                    const uint64_t segmentFrames = (uint64_t)(segmentBars * meter[0] * 60.0 / bpm * sampleRate);
+                    for (uint64_t done = 0; done < segmentFrames; )
+                    {
+                        const uint32_t n = (uint32_t)std::min<uint64_t>(blockSize, segmentFrames - done);
+                        const LiveCutTransport transport = { bpm, meter[0], meter[1], beats, frame };
+
+                        arm_allocation_guard();
+                        if (calls % 97 == 0)
+                            host_parameter_change(engine, changes++, lastIndex, lastValue);
+                        engine.run(inL.data(), inR.data(), outL.data(), outR.data(), n, transport);
+                        size_t size = 0;
+                        const uint64_t allocs = disarm_allocation_guard(&size);
+                        ++calls;
+
+                        if (allocs)
+                        {
+                            if (failures < 10)
+                                std::printf("allocation in the audio thread: cutproc %ld subdiv %ld%s, %.1f bpm %g/%g, frame %llu, "
+                                            "after parameter %u = %g, %llu allocations, first of %zu bytes\n", cutproc,
+                                            LVC_SUBDIV_OPTIONS[subdiv], pitched ? " pitch" : "", bpm, meter[0], meter[1],
+                                            (unsigned long long)frame, lastIndex, lastValue,
+                                            (unsigned long long)allocs, size);
+                            ++failures;
+                        }
+
+                        frame += n;
+                        done += n;
+                        beats += n / sampleRate * bpm / 60.0;
+                    }
+                    barsDone += segmentBars;
+                }
+                engine.deactivate();
+            }
+
+    std::printf("alloc guard: %ld run() calls, %ld parameter changes, %ld allocated\n", calls, changes, failures);
+    return failures;
+}
+
+int main(int argc, char** argv)
+{
+    double scale = 1.0;
+    bool guard = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!std::strcmp(argv[i], "--quick"))
+            scale = 0.1;
+        else if (!std::strcmp(argv[i], "--alloc-guard"))
+            guard = true;
+        else
+        {
+            std::fprintf(stderr, "usage: livecut-bench [--quick] [--alloc-guard]\n");
+            return 1;
+        }
+    }
+
+    if (guard)
+        return alloc_guard((long)(100 * scale)) ? 1 : 0;
+
+    const long units = (long)(2048 * scale);
+    const long frames = (long)(4 * 1048576 * scale);
+    const long phrases = (long)(2000 * scale);
+
+    std::printf("%-44s %10s %14s %12s\n", "", "ns/sample", "worst bound ns", "allocs/s");
+    bench_player(units);
+    bench_crusher(units);
+    bench_comb(units);
+    bench_delayline(frames);
+    bench_lowpass(frames);
+
+    std::printf("\n%-44s %10s %14s %12s\n", "", "ns/call", "worst call ns", "allocs/s");
+    bench_choosecuts(phrases);
+    return 0;
+}
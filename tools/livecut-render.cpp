@@ -0,0 +1,133 @@
+/*
+ This file is part of Livecut
+ Copyright 2004 by Remy Muller.
+ Adapted for DISTRHO Plugin Framework (DPF) by eventual-recluse.
+
+ Livecut can be redistributed and/or modified under the terms of the
+ GNU General Public License, as published by the Free Software Foundation;
+ either version 2 of the License, or (at your option) any later version.
+
+ Livecut is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Livecut; if not, visit www.gnu.org/licenses or write to the
+ Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ Boston, MA 02111-1307 USA
+ */
+
+/* livecut-render: streams a WAV file through the Livecut processing chain, without a host */
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "Render.hpp"
+
+static void usage()
+{
+    std::fprintf(stderr,
+        "usage: livecut-render [options] input.wav output.wav\n"
+        "  --bpm X               tempo in beats per minute (default 120)\n"
+        "  --meter N/D           time signature (default 4/4)\n"
+        "  --seed N              random seed, same as livecut_seed (default 1)\n"
+        "  --set NAME=VALUE      set a parameter by symbol (livecut_subdiv or subdiv) or index,\n"
+        "                        may be repeated\n"
+        "  --block-size N        frames per run() call (default 4096)\n"
+        "  --bits 16|24|32       output sample format, 32 is float (default 32)\n"
+        "  --planner             plan the cuts on a background thread\n"
+        "  --profile             print a histogram of the time taken by each run() call\n"
+        "  --list                print the parameters with their default and range\n");
+}
+
+int main(int argc, char** argv)
+{
+    RenderJob job;
+    int paths = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+        if (!std::strcmp(arg, "--planner"))
+        {
+            job.usePlanner = true;
+        }
+        else if (!std::strcmp(arg, "--profile"))
+        {
+            job.profile = true;
+        }
+        else if (!std::strcmp(arg, "--list"))
+        {
+            list_parameters();
+            return 0;
+        }
+        else if (!std::strcmp(arg, "--help") || !std::strcmp(arg, "-h"))
+        {
+            usage();
+            return 0;
+        }
+        else if (!std::strncmp(arg, "--", 2))
+        {
+            if (!value)
+            {
+                std::fprintf(stderr, "livecut-render: %s needs a value\n", arg);
+                return 1;
+            }
+            ++i;
+
+            std::string option;
+            if (!std::strcmp(arg, "--set"))
+                option = value;
+            else if (!std::strcmp(arg, "--block-size"))
+                option = std::string("block=") + value;
+            else if (!std::strcmp(arg, "--bpm") || !std::strcmp(arg, "--meter") || !std::strcmp(arg, "--seed") || !std::strcmp(arg, "--bits"))
+                option = std::string(arg + 2) + "=" + value;
+            else
+            {
+                std::fprintf(stderr, "livecut-render: unknown option %s\n", arg);
+                usage();
+                return 1;
+            }
+
+            std::string error;
+            if (!parse_option(job, option, error))
+            {
+                std::fprintf(stderr, "livecut-render: %s\n", error.c_str());
+                return 1;
+            }
+        }
+        else if (paths == 0)
+        {
+            job.input = arg;
+            ++paths;
+        }
+        else if (paths == 1)
+        {
+            job.output = arg;
+            ++paths;
+        }
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+
+    if (paths != 2)
+    {
+        usage();
+        return 1;
+    }
+
+    std::string error;
+    if (!render(job, error))
+    {
+        std::fprintf(stderr, "livecut-render: %s\n", error.c_str());
+        return 1;
+    }
+    return 0;
+}